@@ -0,0 +1,39 @@
+/*
+ Arena allocator for DP storage
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+typedef enum {
+    ARENA_PAGES_SMALL,       // base pages
+    ARENA_PAGES_TRANSPARENT, // blocks aligned on HUGE_PAGE_SIZE and advised as transparent huge pages
+    ARENA_PAGES_EXPLICIT     // pages of the hugetlbfs pool (MAP_HUGETLB), or transparent ones when the pool is empty
+} arenaPages;
+
+typedef struct arenaBlock {
+    struct arenaBlock* next;
+    size_t size;          // bytes mapped for this block, header included
+    size_t used;          // bytes handed out, header included
+} arenaBlock;
+
+typedef struct {
+    arenaBlock* blocks;   // most recent block first
+    size_t blockSize;     // default size of a block
+    size_t mapped;        // total bytes mapped
+    arenaPages pages;
+    int fallbacks;        // ARENA_PAGES_EXPLICIT blocks mapped with transparent huge pages instead
+} arena;
+
+arena* arenaCreate(size_t blockSize);
+arena* arenaCreatePages(size_t blockSize, arenaPages pages);
+const char* arenaPagesName(arenaPages pages);
+void* arenaAlloc(arena* a, size_t bytes);
+void arenaRelease(arena* a, void* p, size_t bytes);
+void arenaFree(arena* a);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ Balas-Simonetti neighbourhood: best tour in which no vertex moves by k positions or more
+ */
+
+#ifndef BALAS_SIMONETTI_H
+#define BALAS_SIMONETTI_H
+
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+#define BS_MAX_WIDTH 16 // the vertices placed ahead of the frontier are a subset of k-1 elements
+// the pred table of width k takes (n+1) 2^(k-1) 2k bytes: 1.05 GB for k = 16 and n = 1000, 10 MB for k = 10
+#define BS_MAX_TABLE_BYTES ((size_t)1 << 30) // bsCreate refuses larger tables (see bsMaxWidth)
+
+typedef struct {
+    int n;
+    int k;              // width of the neighbourhood
+    int nbStates;       // number of states (S,d) of a frontier: 2^(k-1) * 2k
+    int32_t* dp;        // k+1 layers of nbStates cells, used as a ring indexed by the frontier
+    int8_t* pred;       // n+1 layers of nbStates cells: last vertex of the previous state, for the reconstruction
+    int* order;         // the new tour, before it is copied into sol
+} bsTable;
+
+typedef struct {
+    int steps;          // number of neighbourhoods explored (the last two do not improve the tour)
+    int improvements;
+    double seconds;
+} bsStats;
+
+size_t bsTableBytes(int n, int k);
+int bsMaxWidth(int n);
+bsTable* bsCreate(int n, int k);
+void bsFree(bsTable* t);
+int bsStep(bsTable* t, int* sol, int offset, const costProvider* cost);
+int balasSimonettiLS(bsTable* t, int* sol, int total, const costProvider* cost, bsStats* stats);
+
+#endif
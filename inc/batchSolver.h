@@ -0,0 +1,55 @@
+/*
+ Batch solver: a stream of small instances solved with tables reused from one instance to the next
+ */
+
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "hkTable.h"
+#include "costProvider.h"
+
+#define BATCH_MAX_VERTICES 24 // the table of a thread takes 8 n 2^(n-1) bytes: 1.6 GB for 24 vertices
+#define BATCH_SIZE 256        // largest number of instances solved together
+
+typedef struct {
+    int n;              // number of vertices, or -1 if the line is not a valid instance
+    double xy[2*BATCH_MAX_VERTICES];
+    int length;         // length of the optimal tour (-1 if the instance is invalid or too large for the memory)
+    int tour[BATCH_MAX_VERTICES];
+} batchInstance;
+
+typedef struct {
+    int nmax;           // largest number of vertices the table can hold (0: no table yet)
+    hkTable* table;     // S-major dp and succ blocks, grown to the largest instance and already touched
+    int32_t* matrix;    // costs of the current instance
+    costProvider cost;  // view of matrix as a cost provider
+    uint64_t growths;   // number of times the table was reallocated for a larger instance
+    pthread_t thread;
+} batchArena;
+
+typedef struct {
+    uint64_t instances; // instances answered (including the invalid ones)
+    uint64_t invalid;
+    uint64_t batches;
+    int nmax;           // largest number of vertices of an instance
+    double seconds;     // time spent reading, solving and writing
+} batchStats;
+
+typedef struct {
+    int nbThreads;
+    batchArena* arenas; // one per thread, kept from one stream to the next
+    batchInstance* instances;
+    batchStats stats;
+} batchServer;
+
+batchServer* batchServerCreate(int nbThreads);
+void batchServerFree(batchServer* s);
+size_t batchTableBytes(const batchServer* s);
+uint64_t batchGrowths(const batchServer* s);
+int batchServe(batchServer* s, int in, int out);
+int batchListen(const char* path);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ Cost of the arcs of an instance, stored as a matrix or computed from the coordinates of the vertices
+ */
+
+#ifndef COST_PROVIDER_H
+#define COST_PROVIDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+typedef enum {
+    COST_MATRIX16,   // n x n matrix of 16-bit cells, used when the largest cost fits
+    COST_MATRIX32,   // n x n matrix of 32-bit cells
+    COST_COORDS      // no matrix: costs are computed from the coordinates, in O(n) memory
+} costKind;
+
+typedef enum {
+    METRIC_TRUNC_2D, // Euclidean distance rounded down (the random instances of createCost)
+    METRIC_EUC_2D,   // Euclidean distance rounded to the nearest integer (TSPLIB EUC_2D)
+    METRIC_CEIL_2D,  // Euclidean distance rounded up (TSPLIB CEIL_2D)
+    METRIC_ATT,      // pseudo-Euclidean distance (TSPLIB ATT)
+    METRIC_GEO       // distance on the Earth, from latitudes and longitudes in radians (TSPLIB GEO)
+} costMetric;
+
+#define EARTH_RADIUS 6378.388 // km, as in TSPLIB
+
+typedef struct {
+    costKind kind;
+    costMetric metric;
+    int n;
+    size_t stride;      // number of cells of a row, padded to a multiple of 64 bytes
+    uint16_t* m16;      // COST_MATRIX16: cost of (i,j) in m16[i*stride + j]
+    int32_t* m32;       // COST_MATRIX32: cost of (i,j) in m32[i*stride + j]
+    double* xy;         // coordinates of vertex i in xy[2i] and xy[2i+1] (NULL for a matrix given explicitly)
+    int maxCost;        // largest cost between two different vertices
+} costProvider;
+
+static inline int metricCost(costMetric metric, const double* xy, int i, int j){
+    // Postrelation: return the cost of (i,j) according to metric (rounded as specified by TSPLIB)
+    double dx = xy[2*i] - xy[2*j], dy = xy[2*i+1] - xy[2*j+1];
+    switch (metric){
+        case METRIC_TRUNC_2D:
+            return (int)sqrt(dx*dx + dy*dy);
+        case METRIC_EUC_2D:
+            return (int)(sqrt(dx*dx + dy*dy) + 0.5);
+        case METRIC_CEIL_2D:
+            return (int)ceil(sqrt(dx*dx + dy*dy));
+        case METRIC_ATT: {
+            double r = sqrt((dx*dx + dy*dy) / 10.0);
+            int t = (int)(r + 0.5);
+            return (t < r) ? t+1 : t;
+        }
+        default: {
+            if (i == j) return 0;
+            double q1 = cos(xy[2*i+1] - xy[2*j+1]);
+            double q2 = cos(xy[2*i] - xy[2*j]);
+            double q3 = cos(xy[2*i] + xy[2*j]);
+            return (int)(EARTH_RADIUS * acos(0.5*((1.0+q1)*q2 - (1.0-q1)*q3)) + 1.0);
+        }
+    }
+}
+
+static inline int metricLowerBound(costMetric metric, double d){
+    // Precondition: metric is planar (not METRIC_GEO)
+    // Postrelation: return a lower bound of the cost of two vertices whose coordinates are at least d apart
+    if (metric == METRIC_ATT) d /= sqrt(10.0);
+    return (int)d - 1; // 1 below, for the rounding errors on d
+}
+
+static inline int costOf(const costProvider* c, int i, int j){
+    // Postrelation: return the cost of arc (i,j) (0 if i = j)
+    switch (c->kind){
+        case COST_MATRIX16:
+            return c->m16[(size_t)i*c->stride + j];
+        case COST_MATRIX32:
+            return c->m32[(size_t)i*c->stride + j];
+        default:
+            return metricCost(c->metric, c->xy, i, j);
+    }
+}
+
+costProvider* costFromPoints(int n, const double* xy, costMetric metric, costKind kind);
+costProvider* costFromWeights(int n, const int32_t* weights, costKind kind);
+void costFree(costProvider* c);
+size_t costBytes(const costProvider* c);
+const char* costKindName(costKind kind);
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ Held-Karp dynamic programming: recursive, memoised and bottom-up versions
+ */
+
+#ifndef HELD_KARP_H
+#define HELD_KARP_H
+
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+#include "memoTable.h"
+#include "arena.h"
+
+extern uint64_t nb_calls;  // number of calls to computeD or computeD_memo
+extern uint64_t nb_states; // number of states computed by heldKarp_iter
+
+int computeD(int i, set s, int n, const costProvider* cost);
+int computeD_memo(int i, set s, int n, const costProvider* cost, memoTable* memo);
+int heldKarp_iter(int n, const costProvider* cost, int **dp, int **succ);
+void printTour(int n, int **succ);
+int** allocRows(int n);
+int** allocRowsPages(int n, arenaPages pages);
+arena* rowsArena(int** rows);
+void freeRows(int n, int** rows);
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ Bounded-width (beam) Held-Karp: heuristic tours at any number of vertices
+ */
+
+#ifndef HK_BEAM_H
+#define HK_BEAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "costProvider.h"
+
+typedef struct {
+    int32_t parent;     // index of the previous state in its layer (0, the depot, for the states of layer 1; layer 0 is not stored)
+    int32_t vertex;     // vertex added by this state
+} beamParent;
+
+typedef struct {
+    int n;
+    int width;          // B: number of states kept per layer
+    int words;          // number of 64-bit words of a set of vertices
+    // layer being expanded (cur) and layer being built (next)
+    uint64_t* sets[2];  // sets[l][s*words..] = vertices visited by state s (a bit vector of n bits)
+    uint64_t* hashes[2];// Zobrist hash of each set
+    int32_t* values[2]; // length of the path from 0 ending on the vertex of the state
+    int32_t* vertices[2]; // vertex of the state (the last one of its path)
+    int count[2];       // number of states of each layer
+    beamParent* parents;// parents[k*width + s] = how state s of layer k was reached, for the reconstruction
+    // candidates of the layer being built: a max-heap of at most B states on their values,
+    // and an open-addressing hash table from (vertex, set) to their slots
+    int32_t* candValue;
+    int32_t* candParent;
+    int32_t* candVertex;
+    uint64_t* candHash;
+    int32_t* heap;      // heap[h] = slot of the h-th element of the heap
+    int32_t* heapPos;   // heapPos[slot] = position of slot in heap
+    int32_t* table;     // slot of each cell of the hash table, or -1
+    size_t tableMask;   // number of cells - 1 (power of 2, at least twice B)
+    uint64_t* zobrist;  // random key of each vertex
+} hkBeam;
+
+typedef struct {
+    uint64_t generated; // candidate states generated
+    uint64_t merged;    // candidates that were already in the layer (the best value is kept)
+    uint64_t evicted;   // candidates pushed out of a full layer by better ones
+} beamStats;
+
+hkBeam* hkBeamCreate(int n, int width);
+void hkBeamFree(hkBeam* b);
+size_t hkBeamBytes(const hkBeam* b);
+int heldKarp_beam(int n, const costProvider* cost, hkBeam* b, int* tour, beamStats* stats);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ Bidirectional (meet-in-the-middle) bottom-up Held-Karp algorithm for symmetric costs
+ */
+
+#ifndef HK_BIDIR_H
+#define HK_BIDIR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+typedef struct {
+    int n;
+    int half;               // last layer computed: subsets of at most half = ceil((n-2)/2) vertices
+    uint8_t* succ;          // successors of the layers 0..half, one byte per cell
+    size_t layerOffset[33]; // first successor cell of each layer
+    set middleSet;          // the tour is 0 -> (middleSet) -> middleVertex -> (the other vertices) -> 0
+    int middleVertex;
+    size_t peakTableBytes;  // largest amount of memory held by the tables at a same time
+} hkBidir;
+
+hkBidir* hkBidirCreate(int n);
+void hkBidirFree(hkBidir* b);
+int heldKarp_bidir(int n, const costProvider* cost, hkBidir* b);
+void tour_bidir(const hkBidir* b, int* tour);
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ Memoised DP with branch-and-bound pruning
+ */
+
+#ifndef HK_BOUNDED_H
+#define HK_BOUNDED_H
+
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+#include "memoTable.h"
+
+typedef struct {
+    uint64_t expanded; // states whose successors have been enumerated
+    uint64_t pruned;   // states cut because their cost plus the lower bound reaches the incumbent
+    uint64_t reused;   // states answered by the memoisation table
+} bbStats;
+
+int lowerBound(int i, set s, const costProvider* cost);
+int computeD_bounded(int i, set s, int budget, int n, const costProvider* cost, memoTable* memo, bbStats* stats);
+int solveBounded(int n, const costProvider* cost, memoTable* memo, int* sol, bbStats* stats);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ Low-memory bottom-up Held-Karp algorithm
+ */
+
+#ifndef HK_COMPACT_H
+#define HK_COMPACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+typedef struct {
+    int n;
+    int upperBound;      // length of a tour, every partial path longer than this is useless
+    int costBytes;       // width of a cost cell: 2 or 4 bytes
+    uint64_t* succ;      // successors packed on SUCC_BITS bits, for all layers
+    size_t layerOffset[33]; // first successor cell of each layer
+    int firstVertex;     // first vertex visited after the depot (0)
+    size_t peakTableBytes; // largest amount of memory held by the tables at a same time
+} hkCompact;
+
+hkCompact* hkCompactCreate(int n, const costProvider* cost);
+void hkCompactFree(hkCompact* c);
+int heldKarp_compact(int n, const costProvider* cost, hkCompact* c);
+void printTour_compact(const hkCompact* c);
+
+#endif
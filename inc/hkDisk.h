@@ -0,0 +1,30 @@
+/*
+ Out-of-core bottom-up Held-Karp algorithm: the layers are streamed to files
+ */
+
+#ifndef HK_DISK_H
+#define HK_DISK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+typedef struct {
+    int n;
+    const char* dir;        // directory of the layer files
+    int succFd;             // successors of all layers, one byte per cell (the file is already unlinked)
+    size_t layerOffset[33]; // first cell of each layer, in both the cost and successor files
+    int firstVertex;        // first vertex visited after the depot (0)
+    size_t bufferBytes;     // size of each write buffer
+    uint64_t bytesWritten;  // bytes written to the layer files
+    uint64_t bytesMapped;   // bytes of the previous layers mapped for reading
+    size_t peakDiskBytes;   // largest amount of disk space used at a same time
+} hkDisk;
+
+hkDisk* hkDiskCreate(int n, const char* dir);
+void hkDiskFree(hkDisk* d);
+int heldKarp_disk(int n, const costProvider* cost, hkDisk* d, double* layerTime);
+void printTour_disk(const hkDisk* d);
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ Multi-process bottom-up Held-Karp algorithm: the layers are shared over local sockets
+ */
+
+#ifndef HK_DISTRIBUTED_H
+#define HK_DISTRIBUTED_H
+
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+typedef struct {
+    double compute[33];       // compute[k] = largest time spent by a worker on its share of layer k
+    double communication[33]; // communication[k] = average time spent by a worker exchanging layer k
+                              // (sending its share, waiting for the others, receiving the layer)
+    uint64_t bytes[33];       // bytes[k] = bytes of layer k sent over the sockets
+} hkDistStats;
+
+int heldKarp_distributed(int n, const costProvider* cost, int nbWorkers, int** dp, int* tour, hkDistStats* stats);
+
+#endif
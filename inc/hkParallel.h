@@ -0,0 +1,13 @@
+/*
+ Layer-parallel bottom-up Held-Karp algorithm
+ */
+
+#ifndef HK_PARALLEL_H
+#define HK_PARALLEL_H
+
+#include "hkTable.h"
+
+void hkFirstTouch(hkTable* t, int nbThreads);
+int heldKarp_parallel(int n, const costProvider* cost, hkTable* t, int nbThreads, double* layerTime);
+
+#endif
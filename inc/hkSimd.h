@@ -0,0 +1,18 @@
+/*
+ Vectorised kernel for the bottom-up Held-Karp algorithm
+ */
+
+#ifndef HK_SIMD_H
+#define HK_SIMD_H
+
+#include "hkTable.h"
+
+typedef enum {
+    HK_KERNEL_SCALAR, // one vertex i at a time
+    HK_KERNEL_VECTOR  // all vertices i at once, with the widest instruction set enabled at compile time
+} hkKernel;
+
+const char* hkVectorIsa(void);
+int heldKarp_simd(int n, const costProvider* cost, hkTable* t, hkKernel kernel);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ Contiguous DP table engine for the bottom-up Held-Karp algorithm
+ */
+
+#ifndef HK_TABLE_H
+#define HK_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+#include "arena.h"
+
+/**
+ * Memory layout of the dp and succ tables
+ * Both layouts store the n cells (i,S) of a same subset S next to each other,
+ * so that the predecessors dp(j, S\{j}) read while computing S are n cells wide
+ * instead of being spread over n different rows.
+ */
+typedef enum {
+    HK_LAYOUT_SMAJOR,  // cell (i,S) at S*n + i, subsets in numeric order
+    HK_LAYOUT_LAYERED  // cell (i,S) at layerOffset[|S|] + rank(S)*n + i, subsets grouped by size in colex order
+} hkLayout;
+
+typedef struct {
+    int n;                  // number of vertices
+    hkLayout layout;
+    size_t nbCells;         // n * 2^(n-1)
+    int* dp;                // dp[cell(i,S)] = cost of the smallest path from i to 0 visiting each vertex of S
+    int* succ;              // succ[cell(i,S)] = vertex visited just after i on this path
+    size_t layerOffset[33]; // first cell of each layer (HK_LAYOUT_LAYERED only)
+    arena* storage;         // huge-page blocks of dp and succ, zero-filled on first access
+} hkTable;
+
+extern uint64_t binom[33][33]; // binom[a][b] = number of subsets of size b of a set of size a
+
+void initBinom(void);
+
+size_t rankSet(set s);
+set unrankSet(size_t rank, int k);
+
+/**
+ * Compact layers: the layer k only stores the n-1-k cells (i,S) with i not in S, of each subset S of size k
+ * of [1,n-1], subsets in colex order (see rankSet); cell (i,S) is at rankSet(S)*(n-1-k) + compactPosition(i,S)
+ */
+static inline int compactPosition(int i, set s){
+    // Postcondition: return the number of vertices in [1,i-1] which are not in s
+    return (i-1) - setSize(s & createSet(i));
+}
+
+static inline void compactPredecessors(int n, set S, int k, int* bit, size_t* cell){
+    // Precondition: S is a subset of size k >= 1 of [1,n-1]
+    // Postcondition: bit[0..k-1] = the vertices of S minus one, in increasing order, and cell[m] = cell of
+    //                (bit[m]+1, S \ {bit[m]+1}) in the compact layer k-1
+    int e, m = 0;
+    forEachElement(e, S) bit[m++] = e - 1;
+    // the rank of S \ {bit[m]+1} is the sum of the terms of the elements before m (unchanged),
+    // and of the terms of the elements after m, which move down by one place
+    size_t prefix = 0;
+    for (int j=0; j<k; j++){
+        cell[j] = prefix;
+        prefix += binom[bit[j]][j+1];
+    }
+    size_t suffix = 0;
+    for (int j=k-1; j>=0; j--){
+        // vertex bit[j]+1 has bit[j]-j smaller vertices outside of S \ {bit[j]+1}
+        cell[j] = (cell[j] + suffix)*(n-k) + bit[j] - j;
+        suffix += binom[bit[j]][j];
+    }
+}
+
+hkTable* hkTableCreate(int n, hkLayout layout);
+void hkTableFree(hkTable* t);
+void hkTableSetSize(hkTable* t, int n);
+size_t hkCell(const hkTable* t, set s, int i);
+const char* hkLayoutName(hkLayout layout);
+
+void hkInitBase(hkTable* t, const costProvider* cost);
+void hkComputeRange(hkTable* t, const costProvider* cost, int k, size_t first, size_t last);
+int hkCloseTour(hkTable* t, const costProvider* cost);
+int heldKarp_table(int n, const costProvider* cost, hkTable* t, double* layerTime);
+void printTour_table(const hkTable* t);
+
+#endif
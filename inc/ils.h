@@ -0,0 +1,43 @@
+/*
+ Iterated local search with double-bridge kicks and a wall-clock budget
+ */
+
+#ifndef ILS_H
+#define ILS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "neighbourLS.h"
+#include "tourOutput.h"
+#include "balasSimonetti.h"
+
+typedef enum {
+    ILS_ACCEPT_BETTER,     // continue from the new tour if it is not longer than the current one
+    ILS_ACCEPT_WALK,       // always continue from the new tour
+    ILS_ACCEPT_THRESHOLD   // continue from the new tour if it is less than threshold% longer than the best one
+} ilsAccept;
+
+typedef struct {
+    double timeLimit;      // wall-clock budget, in seconds
+    long maxIterations;    // maximum number of kicks (0 for no limit)
+    int kicksPerIteration; // number of double bridges applied before each local search
+    ilsAccept accept;
+    double threshold;      // for ILS_ACCEPT_THRESHOLD, in percent
+    uint64_t seed;
+    FILE* trace;           // if not NULL, receives "seconds,length" each time the best tour improves
+    tourOutput* out;       // if not NULL, receives the best tour each time it improves
+    int bsWidth;           // if > 0, the local search of each iteration is followed by the Balas-Simonetti
+                           // local search of this width
+} ilsParams;
+
+typedef struct {
+    long iterations;
+    long accepted;
+    long improvements;     // number of times the best tour improved
+    double seconds;
+} ilsStats;
+
+int iteratedLS(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves,
+               const ilsParams* params, ilsStats* stats);
+
+#endif
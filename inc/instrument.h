@@ -0,0 +1,87 @@
+/*
+ Instrumentation of the hot paths: per-phase timers, event counters and hardware performance counters
+
+ Everything is compiled out unless INSTRUMENT is set (make INSTRUMENT=1, or 2 for the hardware
+ counters): the macros below then expand to nothing, and the solvers are unchanged.
+ Timers and counters are accumulated in a record local to each thread, without any synchronisation;
+ a thread adds its record to the total of the process with INSTR_MERGE before it ends. The report
+ is written when the program exits (see instrumentInit).
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "timer.h"
+
+#ifndef INSTRUMENT
+#define INSTRUMENT 0
+#endif
+
+typedef enum {
+    PHASE_ALLOC,        // allocation of the DP and memoisation tables
+    PHASE_INIT,         // initialisation of the DP tables
+    PHASE_SWEEP,        // computation of the DP states (bottom-up sweep or memoised recursion)
+    PHASE_RECONSTRUCT,  // reconstruction of the tour from the successors
+    PHASE_DESCENT,      // local search descent
+    NB_PHASES
+} instrPhase;
+
+typedef enum {
+    COUNTER_MEMO_HIT,   // memoGet that finds the state
+    COUNTER_MEMO_MISS,  // memoGet that does not
+    COUNTER_STATES,     // DP states computed by the bottom-up solvers
+    COUNTER_MOVES,      // local search moves evaluated
+    NB_COUNTERS
+} instrCounter;
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,    // last level cache read misses
+    PERF_DTLB_MISSES,   // data TLB read misses
+    NB_PERF_EVENTS
+} instrPerfEvent;
+
+#define INSTR_MAX_LAYERS 33 // layers k = 0..32 of the subsets, by size
+
+typedef struct {
+    double phaseTime[NB_PHASES];        // seconds
+    uint64_t phaseCalls[NB_PHASES];
+    double layerTime[INSTR_MAX_LAYERS]; // seconds spent on the subsets of size k by the layered solvers
+    uint64_t counters[NB_COUNTERS];
+} instrRecord;
+
+void instrumentInit(const char* reportPath);
+void instrumentMerge(void);
+void instrumentReport(FILE* f);
+void perfBegin(void);
+void perfEnd(void);
+
+#if INSTRUMENT
+extern _Thread_local instrRecord instrLocal;
+
+#define INSTR_START(t) double t = wallTime()
+#define INSTR_PHASE(p, t) (instrLocal.phaseTime[p] += wallTime() - (t), instrLocal.phaseCalls[p]++)
+#define INSTR_LAYER(k, t) (instrLocal.layerTime[k] += wallTime() - (t))
+#define INSTR_COUNT(c, v) (instrLocal.counters[c] += (v))
+#define INSTR_MERGE() instrumentMerge()
+#else
+#define INSTR_START(t)
+#define INSTR_PHASE(p, t) ((void)0)
+#define INSTR_LAYER(k, t) ((void)0)
+#define INSTR_COUNT(c, v) ((void)0)
+#define INSTR_MERGE() ((void)0)
+#endif
+
+#if INSTRUMENT >= 2
+#define INSTR_PERF_BEGIN() perfBegin()
+#define INSTR_PERF_END() perfEnd()
+#else
+#define INSTR_PERF_BEGIN() ((void)0)
+#define INSTR_PERF_END() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ Local search on tours represented by a permutation sol[0..n-1] of the vertices
+ */
+
+#ifndef LOCAL_SEARCH_H
+#define LOCAL_SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rng.h"
+#include "costProvider.h"
+
+bool isCrossing(int node0, int node1, int nodeLast, int nodeNew, const costProvider* cost);
+bool is_2opt(int v_i0, int v_i1, int v_j0, int v_j1, const costProvider* cost);
+void swap(int* sol, int i, int j);
+bool while_procedure(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated);
+void print_sol(int* sol, int n);
+int compute_sol_length(int* sol, int n, const costProvider* cost);
+void print_sol_with_cost(int* sol, int n, const costProvider* cost);
+int greedyLS(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated);
+int greedyLS2(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated);
+int nearestNeighbourTour(int n, const costProvider* cost, int* sol);
+int randomTour(int n, const costProvider* cost, rng* r, int* sol);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ Memoisation tables for the top-down DP solvers
+ */
+
+#ifndef MEMO_TABLE_H
+#define MEMO_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "set.h"
+#include "arena.h"
+
+typedef enum {
+    MEMO_DENSE,  // n rows of 2^(n-1) cells, limited to DENSE_MAX_VERTICES
+    MEMO_SPARSE  // open-addressing hash table on (i,s), sized by the number of stored states
+} memoKind;
+
+typedef struct {
+    set s;
+    int32_t tag;   // i+1 for a used slot, 0 for an empty one
+    int32_t value;
+} memoSlot;
+
+typedef struct {
+    memoSlot* slots;
+    size_t capacity;   // power of 2
+    size_t count;
+} memoHash;
+
+typedef struct {
+    memoKind kind;
+    int n;
+    arena* storage;
+    int32_t** rows;      // MEMO_DENSE: rows[i][s] = value+1, or 0 if unknown
+    memoHash cur;        // MEMO_SPARSE: table receiving new states
+    memoHash old;        // MEMO_SPARSE: table being migrated to cur after a growth (capacity 0 otherwise)
+    size_t migrated;     // number of slots of old already moved to cur
+    uint64_t lookups;    // number of memoGet and memoPut
+    uint64_t probes;     // number of slots read by these operations
+    uint64_t maxProbe;   // longest probe sequence
+} memoTable;
+
+memoTable* memoCreate(memoKind kind, int n);
+void memoFree(memoTable* m);
+bool memoGet(memoTable* m, int i, set s, int* value);
+void memoPut(memoTable* m, int i, set s, int value);
+size_t memoCount(const memoTable* m);
+double memoLoadFactor(const memoTable* m);
+size_t memoBytes(const memoTable* m);
+const char* memoKindName(memoKind kind);
+
+#endif
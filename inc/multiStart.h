@@ -0,0 +1,20 @@
+/*
+ Parallel multi-start local search
+ */
+
+#ifndef MULTI_START_H
+#define MULTI_START_H
+
+#include <stdint.h>
+#include "neighbourLS.h"
+
+typedef struct {
+    int bestRestart;     // number of the restart which found the best tour
+    double seconds;      // wall-clock time
+    int* restartsDone;   // restartsDone[w] = number of restarts run by thread w (nbThreads cells, allocated by the caller or NULL)
+} msStats;
+
+int multiStartLS(int n, const costProvider* cost, const candidateLists* cand, int moves, int nbRestarts, int nbThreads,
+                 uint64_t seed, int* best, msStats* stats);
+
+#endif
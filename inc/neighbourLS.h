@@ -0,0 +1,79 @@
+/*
+ Local search restricted to candidate lists, for large instances
+ */
+
+#ifndef NEIGHBOUR_LS_H
+#define NEIGHBOUR_LS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "costProvider.h"
+#include "tourList.h"
+
+typedef struct {
+    int n;
+    int k;              // number of candidates per vertex
+    int* neighbours;    // neighbours[i*k .. i*k+k-1] = the k nearest vertices of i, by increasing cost
+} candidateLists;
+
+typedef enum {
+    LS_2OPT = 0,        // replace two edges, reversing the path between them
+    LS_OROPT = 1,       // move a segment of 1 to 3 vertices elsewhere, in either orientation
+    LS_OR3OPT = 2,      // exchange two consecutive segments of any length (3-opt move without reversal)
+    LS_NB_MOVES = 3
+} lsMove;
+
+#define LS_MOVE_BIT(m) (1 << (m))
+
+#define LS_LIST_MIN_VERTICES 8000 // LS_TOUR_AUTO stores the tours of at least this many vertices in two-level lists (full searches)
+
+typedef enum {
+    LS_TOUR_AUTO,       // LS_TOUR_LIST for full searches from LS_LIST_MIN_VERTICES vertices, LS_TOUR_ARRAY otherwise
+    LS_TOUR_ARRAY,      // permutation and position of each vertex: O(1) queries, O(n) reversals
+    LS_TOUR_LIST        // two-level doubly-linked list (see tourList.h): O(1) queries, O(sqrt(n)) reversals
+} lsTour;
+
+extern lsTour lsTourChoice; // representation of the tour searched by neighbourLS (LS_TOUR_AUTO by default)
+
+typedef struct {
+    uint64_t evaluated[LS_NB_MOVES]; // number of moves whose delta has been computed
+    uint64_t applied[LS_NB_MOVES];   // number of improving moves applied
+    uint64_t cycles[LS_NB_MOVES];    // time spent searching each neighbourhood (see cycleCount)
+    double seconds;                  // wall-clock time of the whole search
+} lsStats;
+
+typedef struct {
+    int n;
+    int* sol;           // the tour (that of the caller), up to date unless list is used (see lsSearchSync)
+    int* pos;           // pos[sol[p]] = p
+    tourList* list;     // the tour, instead of sol and pos, if not NULL
+    int* queue;         // circular FIFO of the vertices to search
+    bool* queued;       // queued[v] = v is in the queue (its don't-look bit is off)
+    int head, size;
+    int* log;           // 2-opt moves applied since lsSearchMark, 4 vertices each, so that they can be undone
+    int logSize, logCapacity;
+    bool logging;       // lsSearchMark has been called
+    bool failed;        // the log could not grow
+} lsSearch;             // state of the local search, kept from one search to the next (e.g. by the ILS)
+
+candidateLists* candidatesCreate(int n, const costProvider* cost, int k);
+void candidatesFree(candidateLists* c);
+int neighbourLS(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves, lsStats* stats);
+int neighbourLSFrom(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves,
+                    const int* start, int nbStart, lsStats* stats);
+lsSearch* lsSearchCreate(int n, int* sol, bool useList);
+void lsSearchFree(lsSearch* s);
+void lsSearchReload(lsSearch* s);
+void lsSearchSync(lsSearch* s);
+int lsSearchNext(const lsSearch* s, int v);
+void lsSearchExchange(lsSearch* s, int a, int b1, int b2, int c1, int c2, int d);
+void lsSearchMark(lsSearch* s);
+void lsSearchUndo(lsSearch* s);
+int lsSearchRun(lsSearch* s, int total, const costProvider* cost, const candidateLists* c, int moves,
+                const int* start, int nbStart, lsStats* stats);
+int neighbourLS2(int n, int* sol, int total, const costProvider* cost, const candidateLists* c);
+const char* lsMoveName(lsMove m);
+const char* lsTourName(lsTour r);
+double lsMovesPerSecond(const lsStats* stats, lsMove m);
+
+#endif
@@ -0,0 +1,39 @@
+/*
+ Pseudo-random number generator with an explicit state, so that concurrent runs do not share one
+
+ rngInit derives the state of a stream from a seed and a stream number (e.g. the number of a
+ restart), so that the numbers drawn by a run only depend on the seed and on that number, and not
+ on the thread that executes it. The generator is splitmix64.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint64_t state;
+} rng;
+
+static inline uint64_t rngNext64(rng* r){
+    // Postcondition: return the next 64-bit value of the sequence of r
+    uint64_t z = (r->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline void rngInit(rng* r, uint64_t seed, uint64_t stream){
+    // Postcondition: r is the start of the sequence number stream of seed
+    r->state = seed;
+    r->state = rngNext64(r) ^ (stream * 0xD1B54A32D192ED03ull);
+    rngNext64(r);
+}
+
+static inline int rngNext(rng* r, int n){
+    // Precondition: n > 0
+    // Postcondition: return an integer value in [0,n-1]
+    return (int)(((rngNext64(r) >> 32) * (uint64_t)n) >> 32);
+}
+
+#endif
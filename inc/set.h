@@ -0,0 +1,129 @@
+/*
+ Bit vector representation of the subsets of {1,...,n-1} used by the DP solvers
+
+ The width of the bit vector is chosen at compile time with -D SET_BITS=32, 64 or 128
+ (32 by default). Element e is stored on bit e-1, so a set of SET_BITS bits can hold
+ the vertices 1..SET_BITS, i.e. instances of up to SET_MAX_VERTICES vertices with the depot.
+ Tables indexed by a set (memo, dp, succ) need 2^(n-1) cells per vertex and are limited
+ to DENSE_MAX_VERTICES vertices, whatever the width.
+ */
+
+#ifndef SET_H
+#define SET_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef SET_BITS
+#define SET_BITS 32
+#endif
+
+#if SET_BITS == 32
+typedef uint32_t set; // representation of a set with a bit vector
+#elif SET_BITS == 64
+typedef uint64_t set;
+#elif SET_BITS == 128
+typedef unsigned __int128 set;
+#else
+#error "SET_BITS must be 32, 64 or 128"
+#endif
+
+#define SET_MAX_VERTICES (SET_BITS + 1)
+#define DENSE_MAX_VERTICES 32
+
+static inline set singleton(int e){
+    // Precondition: 1 <= e <= SET_BITS
+    // Postrelation: return the set {e}
+    return (set)1 << (e-1);
+}
+
+static inline bool isIn(int e, set s){
+    // Precondition: 1 <= e <= SET_BITS
+    // Postrelation: return true if e belongs to s
+    return ((s & singleton(e)) != 0);
+}
+
+static inline bool isEmpty(set s){
+    // Postrelation: return true if s is empty
+    return (s == 0);
+}
+
+static inline set addElement(set s, int e){
+    // Precondition: 1 <= e <= SET_BITS
+    // Postrelation: return the set s U {e}
+    return (s | singleton(e));
+}
+
+static inline set removeElement(set s, int e){
+    // Precondition: 1 <= e <= SET_BITS and e belongs to s
+    // Postrelation: return the set s \ {e}
+    return (s ^ singleton(e));
+}
+
+static inline set createSet(int n){
+    // Precondition: 1 <= n <= SET_MAX_VERTICES
+    // Postrelation: return the set that contains all integer ranging from 1 to n-1
+    if (n - 1 == SET_BITS) return ~(set)0;
+    return ((set)1 << (n - 1)) - 1;
+}
+
+static inline int setSize(set s){
+    // Postrelation: return the number of elements of s
+#if SET_BITS == 32
+    return __builtin_popcount(s);
+#elif SET_BITS == 64
+    return __builtin_popcountll(s);
+#else
+    return __builtin_popcountll((uint64_t)s) + __builtin_popcountll((uint64_t)(s >> 64));
+#endif
+}
+
+static inline int setFirst(set s){
+    // Precondition: s is not empty
+    // Postrelation: return the smallest element of s
+#if SET_BITS == 32
+    return __builtin_ctz(s) + 1;
+#elif SET_BITS == 64
+    return __builtin_ctzll(s) + 1;
+#else
+    uint64_t low = (uint64_t)s;
+    return (low != 0) ? __builtin_ctzll(low) + 1 : __builtin_ctzll((uint64_t)(s >> 64)) + 65;
+#endif
+}
+
+static inline set removeFirst(set s){
+    // Postrelation: return s without its smallest element
+    return s & (s - 1);
+}
+
+/**
+ * Iterate over the elements of a set, in increasing order, with one step per element:
+ *     int j;
+ *     forEachElement(j, s) { ... }
+ */
+#define forEachElement(e, s) \
+    for (set e##Rest = (s); e##Rest != 0 && ((e) = setFirst(e##Rest), true); e##Rest = removeFirst(e##Rest))
+
+static inline size_t setIndex(set s){
+    // Precondition: s is a subset of {1,...,DENSE_MAX_VERTICES-1}
+    // Postrelation: return the index of s in a table of 2^(n-1) cells
+    return (size_t)s;
+}
+
+static inline set nextSetOfSameSize(set s){
+    // Precondition: s is not empty
+    // Postrelation: return the smallest set greater than s (as an integer) with the same number of elements (Gosper's hack)
+    set c = s & -s;
+    set r = s + c;
+    return (((r ^ s) >> 2) / c) | r;
+}
+
+static inline void printSet(set s){
+    // Postcondition: print all elements of s
+    int i;
+    forEachElement(i, s) printf(" %d", i);
+}
+
+#endif
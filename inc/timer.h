@@ -0,0 +1,30 @@
+/*
+ Wall-clock timing helper (clock() measures CPU time, which hides waiting on memory and parallel speedups)
+ */
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <time.h>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static inline double wallTime(void){
+    // Postcondition: return the current value of the monotonic clock, in seconds
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t cycleCount(void){
+    // Postcondition: return the time stamp counter (reference cycles), or nanoseconds on other architectures
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)(wallTime()*1e9);
+#endif
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ Tour stored in a two-level doubly-linked list: next, prev and between in O(1), flip in O(sqrt(n))
+ */
+
+#ifndef TOUR_LIST_H
+#define TOUR_LIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    int next, prev;     // neighbours inside the segment, in its stored order (-1 at its ends)
+    int seq;            // consecutive integers, increasing along next inside the segment
+    int segment;
+} tourNode;
+
+typedef struct {
+    int first, last;    // ends of the segment in its stored order
+    int size;
+    int next, prev;     // segments that follow and precede it in the tour
+    int rank;           // position of the segment in the tour (0 to nbSegments-1, from any segment)
+    bool reversed;      // the segment is read from last to first in the tour
+} tourSegment;
+
+typedef struct {
+    int n;
+    int groupSize;          // number of vertices of the segments after a rebuild, about sqrt(n)
+    int nbSegments;
+    int maxSegments;        // the segments are rebuilt when a flip could need more
+    tourNode* nodes;
+    tourSegment* segments;
+    int* buffer;            // n vertices, for rebuilds and splits
+    int* run;               // maxSegments segments, for flips
+    uint64_t flips;         // number of flips that changed the tour
+    uint64_t splits;        // number of segments created by a flip
+    uint64_t rebuilds;
+} tourList;
+
+tourList* tourListCreate(int n, const int* sol);
+void tourListFree(tourList* l);
+void tourListToArray(const tourList* l, int first, int* sol);
+void tourFlip(tourList* l, int a, int b, int c, int d);
+
+static inline int tourNext(const tourList* l, int v){
+    // Postcondition: return the vertex that follows v in the tour
+    const tourNode* x = &l->nodes[v];
+    const tourSegment* s = &l->segments[x->segment];
+    int w = s->reversed ? x->prev : x->next;
+    if (w >= 0) return w;
+    const tourSegment* t = &l->segments[s->next];
+    return t->reversed ? t->last : t->first;
+}
+
+static inline int tourPrev(const tourList* l, int v){
+    // Postcondition: return the vertex that precedes v in the tour
+    const tourNode* x = &l->nodes[v];
+    const tourSegment* s = &l->segments[x->segment];
+    int w = s->reversed ? x->next : x->prev;
+    if (w >= 0) return w;
+    const tourSegment* t = &l->segments[s->prev];
+    return t->reversed ? t->first : t->last;
+}
+
+static inline int64_t tourKey(const tourList* l, int v){
+    // Postcondition: return a key of v that increases along the tour, from the first vertex of the segment of rank 0
+    const tourNode* x = &l->nodes[v];
+    const tourSegment* s = &l->segments[x->segment];
+    return ((int64_t)s->rank << 32) + (s->reversed ? -x->seq : x->seq);
+}
+
+static inline bool tourBetween(const tourList* l, int a, int b, int c){
+    // Postcondition: return true if b is on the path from a to c, in the direction of the tour
+    int64_t ka = tourKey(l, a), kb = tourKey(l, b), kc = tourKey(l, c);
+    if (ka <= kc) return ka <= kb && kb <= kc;
+    return kb >= ka || kb <= kc;
+}
+
+#endif
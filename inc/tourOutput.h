@@ -0,0 +1,61 @@
+/*
+ Output of the tours found by the solvers, off the hot path
+ */
+
+#ifndef TOUR_OUTPUT_H
+#define TOUR_OUTPUT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+typedef enum {
+    OUTPUT_OFF,      // tours are not written
+    OUTPUT_BEST,     // only the best tour is kept, and written when the output is closed
+    OUTPUT_STREAM    // every tour is written, by a background thread
+} outputMode;
+
+typedef enum {
+    FORMAT_BINARY,   // header, coordinates, then records (int32 length, int32 tour[n]), in native byte order
+    FORMAT_CSV       // "vertex,x,y" lines, then "length,tour" lines whose tour is space-separated
+} outputFormat;
+
+#define TOUR_MAGIC "TOUR"
+#define TOUR_VERSION 1
+
+typedef struct {
+    char magic[4];        // TOUR_MAGIC
+    int32_t version;      // TOUR_VERSION
+    int32_t n;
+    int32_t hasCoords;    // 1 if n pairs of doubles (x,y) follow the header
+} tourFileHeader;
+
+typedef struct {
+    outputMode mode;
+    outputFormat format;
+    FILE* file;
+    int n;
+    size_t recordBytes;   // (n+1) int32: the length, then the tour
+    // OUTPUT_BEST
+    int32_t* best;        // record of the best tour (best[0] < 0 if none)
+    // OUTPUT_STREAM: records are appended to buffers[filling], while the writer thread writes the other one
+    char* buffers[2];
+    size_t used[2];
+    size_t capacity;      // bytes of each buffer
+    int filling;
+    bool pending;         // the other buffer is full and is being written
+    bool closing;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    uint64_t written;     // number of tours written
+    uint64_t dropped;     // number of tours dropped because both buffers were full
+} tourOutput;
+
+tourOutput* outputOpen(const char* path, outputMode mode, int n, const double* xy);
+void outputTour(tourOutput* out, const int* sol, int length);
+void outputClose(tourOutput* out);
+bool outputParse(const char* spec, outputMode* mode, const char** path);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ Instances and tours in the TSPLIB format
+ */
+
+#ifndef TSPLIB_H
+#define TSPLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "costProvider.h"
+
+typedef struct {
+    char name[64];
+    int n;
+    bool explicitWeights; // EDGE_WEIGHT_TYPE : EXPLICIT, the costs are in weights
+    costMetric metric;    // otherwise, the costs are computed from xy with this metric
+    double* xy;           // coordinates of vertex i in xy[2i] and xy[2i+1] (for GEO, latitude and longitude in radians);
+                          // for EXPLICIT, the display coordinates if the file has some, NULL otherwise
+    int32_t* weights;     // EXPLICIT: cost of (i,j) in weights[i*n+j]
+} tsplibInstance;
+
+tsplibInstance* tsplibLoad(const char* path);
+void tsplibFree(tsplibInstance* inst);
+costProvider* tsplibCost(const tsplibInstance* inst, costKind kind);
+int tsplibTourLength(const char* path, const costProvider* cost);
+int tsplibOptimum(const char* instancePath, const costProvider* cost);
+
+#endif
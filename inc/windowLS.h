@@ -0,0 +1,35 @@
+/*
+ Re-optimisation of a tour by exact DP on windows of consecutive vertices
+ */
+
+#ifndef WINDOW_LS_H
+#define WINDOW_LS_H
+
+#include <stdint.h>
+#include "set.h"
+#include "costProvider.h"
+
+#define WINDOW_MAX_VERTICES 20 // the DP table of a window has k * 2^k cells
+
+typedef struct {
+    int k;              // number of vertices of a window
+    int32_t* dp;        // dp[S*k + i-1] = cost of the shortest path from the i-th vertex of the window to its right end point, visiting S
+    int8_t* succ;       // succ[S*k + i-1] = vertex visited just after the i-th one on this path
+    int32_t* costs;     // costs[(i-1)*k + j-1] = cost between the i-th and the j-th vertices of the window
+    int32_t* toRight;   // toRight[i-1] = cost between the i-th vertex and the right end point
+    int32_t* fromLeft;  // fromLeft[i-1] = cost between the left end point and the i-th vertex
+} windowTable;
+
+typedef struct {
+    int passes;         // number of passes over the tour (the last one does not improve it)
+    long windows;       // number of windows solved
+    long improved;      // number of windows whose order has been changed
+    double seconds;     // wall-clock time
+} windowStats;
+
+windowTable* windowTableCreate(int k);
+void windowTableFree(windowTable* w);
+int windowOptimise(windowTable* w, const costProvider* cost, int left, int* cities, int right);
+int windowLS(int n, int* sol, int total, const costProvider* cost, int k, int nbThreads, windowStats* stats);
+
+#endif
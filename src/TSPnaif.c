@@ -4,208 +4,633 @@
  Ce programme est un logiciel libre ; vous pouvez le redistribuer et/ou le modifier au titre des clauses de la Licence Publique Générale GNU, telle que publiée par la Free Software Foundation. Ce programme est distribué dans l'espoir qu'il sera utile, mais SANS AUCUNE GARANTIE ; sans même une garantie implicite de COMMERCIABILITE ou DE CONFORMITE A UNE UTILISATION PARTICULIERE. Voir la Licence Publique Générale GNU pour plus de détails.
  
  Compile with:
-    gcc -o tspnaif TSPnaif.c -O3 -Wall -lm
+    gcc -o tspnaif TSPnaif.c hkTable.c -I ../inc -O3 -Wall -lm
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <time.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "set.h"
+#include "timer.h"
+#include "heldKarp.h"
+#include "hkTable.h"
+#include "hkParallel.h"
+#include "hkCompact.h"
+#include "hkSimd.h"
+#include "hkBounded.h"
+#include "hkBeam.h"
+#include "hkDisk.h"
+#include "hkBidir.h"
+#include "hkDistributed.h"
+#include "batchSolver.h"
+#include "memoTable.h"
+#include "costProvider.h"
+#include "tsplib.h"
+#include "instrument.h"
 
-typedef int set; // representation of a set with a bit vector
+int iseed = 1;  // Seed used for initialising the pseudo-random number generator
 
-bool isIn(int e, set s){
-    // Precondition: 1 <= e <= 32
-    // Postrelation: return true if e belongs to s
-    return ((s & (1 << (e-1))) != 0);
+int nextRand(int n){
+    // Postcondition: return an integer value in [0,n-1], according to a pseudo-random sequence
+    int i = 16807 * (iseed % 127773) - 2836 * (iseed / 127773);
+    if (i > 0) iseed = i;
+    else iseed = 2147483647 + i;
+    return iseed % n;
 }
 
-bool isEmpty(set s){
-    // Postrelation: return true if s is empty
-    return (s == 0);
+costProvider* createCost(int n, costKind kind){
+    // return the symmetrical costs of n random vertices, such that, for each i,j in [0,n-1], costOf(cost, i, j) = cost of arc (i,j)
+    double xy[2*n];
+    int max = 1000;
+    for (int i=0; i<n; i++){
+        xy[2*i] = nextRand(max);
+        xy[2*i+1] = nextRand(max);
+    }
+    return costFromPoints(n, xy, METRIC_TRUNC_2D, kind);
 }
 
-set addElement(set s, int e){
-    // Precondition: 1 <= e <= 32
-    // Postrelation: return the set s U {e}
-    return (s | (1 << (e-1)));
-}
+int optimum = -1; // length of an optimal tour of the instance, when it is known
 
-set removeElement(set s, int e){
-    // Precondition: 1 <= e <= 32
-    // Postrelation: return the set s \ {e}
-    return (s ^ (1 << (e-1)));
+void printGap(int length){
+    // side effect: print the gap between length and the optimal length, when it is known
+    if (optimum > 0) printf("    - Gap to the optimum (%d) = %.2f%%\n", optimum, 100.0*(length - optimum)/optimum);
 }
 
-set createSet(int n){
-    // Precondition: 1 <= n <= 32
-    // Postrelation: return the set that contains all integer ranging from 1 to n-1
-    return (1 << (n - 1)) - 1;
-}
+/**
+ * Benchmark of the memory layouts of the bottom-up DP table
+ * For each n in [nmin,nmax], solve the same instance with heldKarp_iter (n separate rows)
+ * and with heldKarp_table for each contiguous layout, and print the wall-clock time per state.
+ */
+void benchLayouts(int nmin, int nmax){
+    hkLayout layouts[] = {HK_LAYOUT_SMAJOR, HK_LAYOUT_LAYERED};
+    printf("%3s  %-8s %10s %12s %10s\n", "n", "layout", "time (s)", "ns/state", "length");
+    for (int n=nmin; n<=nmax; n++){
+        iseed = 1;
+        costProvider* cost = createCost(n, COST_MATRIX16);
+        double nbCells = (double)(n-1) * ((size_t)1 << (n-2)); // number of cells (i,S) with i not in S
+
+        int** dp = allocRows(n);
+        int** succ = allocRows(n);
+        int ref = -1;
+        if (dp == NULL || succ == NULL){
+            printf("%3d  %-8s %10s\n", n, "rows", "out of memory");
+        } else {
+            double t = wallTime();
+            ref = heldKarp_iter(n, cost, dp, succ);
+            t = wallTime() - t;
+            printf("%3d  %-8s %10.3f %12.2f %10d\n", n, "rows", t, t*1e9/nbCells, ref);
+        }
+        freeRows(n, dp);
+        freeRows(n, succ);
 
-void printSet(set s){
-    // Postcondition: print all elements of s
-    int i = 1;
-    while (s != 0){
-        if (s%2 != 0) printf(" %d",i);
-        s /= 2;
-        i++;
+        for (int l=0; l<2; l++){
+            hkTable* table = hkTableCreate(n, layouts[l]);
+            if (table == NULL){
+                printf("%3d  %-8s %10s\n", n, hkLayoutName(layouts[l]), "out of memory");
+                continue;
+            }
+            double t = wallTime();
+            int d = heldKarp_table(n, cost, table, NULL);
+            t = wallTime() - t;
+            printf("%3d  %-8s %10.3f %12.2f %10d%s\n", n, hkLayoutName(layouts[l]), t, t*1e9/nbCells, d,
+                   (ref >= 0 && d != ref) ? "  MISMATCH" : "");
+            hkTableFree(table);
+        }
+        costFree(cost);
     }
 }
 
-int iseed = 1;  // Seed used for initialising the pseudo-random number generator
+/**
+ * Solve with the layer-parallel Held-Karp algorithm and compare it, layer by layer,
+ * with the serial computation on the same (layered) table
+ */
+void solveParallel(int n, const costProvider* cost, int nbThreads){
+    hkTable* table = hkTableCreate(n, HK_LAYOUT_LAYERED);
+    if (table == NULL){
+        printf("Not enough memory for the DP table.\n");
+        return;
+    }
+    // touch the table first, so that neither run pays the page faults of the other,
+    // and each page is placed on the NUMA node of the thread that computes its cells
+    hkFirstTouch(table, nbThreads);
+    double serialTime[33], parallelTime[33];
+    double t = wallTime();
+    int ds = heldKarp_table(n, cost, table, serialTime);
+    double ts = wallTime() - t;
+    t = wallTime();
+    int dp = heldKarp_parallel(n, cost, table, nbThreads, parallelTime);
+    double tp = wallTime() - t;
+    if (dp < 0){
+        printf("Not enough memory for the work queues.\n");
+        hkTableFree(table);
+        return;
+    }
 
-int nextRand(int n){
-    // Postcondition: return an integer value in [0,n-1], according to a pseudo-random sequence
-    int i = 16807 * (iseed % 127773) - 2836 * (iseed / 127773);
-    if (i > 0) iseed = i;
-    else iseed = 2147483647 + i;
-    return iseed % n;
+    printf("%3s %12s %12s %12s %8s\n", "k", "subsets", "serial (s)", "parallel (s)", "speedup");
+    for (int k=1; k<n; k++)
+        printf("%3d %12lu %12.4f %12.4f %8.2f\n", k, (unsigned long)binom[n-1][k], serialTime[k], parallelTime[k],
+               parallelTime[k] > 0 ? serialTime[k]/parallelTime[k] : 0);
+    printf("Length of the smallest hamiltonian circuit (serial) = %d; wall time = %.3fs\n", ds, ts);
+    printf("Length of the smallest hamiltonian circuit (%d threads) = %d; wall time = %.3fs; speedup = %.2f\n",
+           nbThreads, dp, tp, tp > 0 ? ts/tp : 0);
+    if (ds != dp) printf("    - MISMATCH between the serial and the parallel solvers\n");
+    printGap(dp);
+    printTour_table(table);
+    hkTableFree(table);
 }
 
-int** createCost(int n){
-    // return a symmetrical cost matrix such that, for each i,j in [0,n-1], cost[i][j] = cost of arc (i,j)
-    int x[n], y[n];
-    int max = 1000;
-    int** cost;
-    cost = (int**) malloc(n*sizeof(int*));
-    for (int i=0; i<n; i++){
-        x[i] = nextRand(max);
-        y[i] = nextRand(max);
-        cost[i] = (int*)malloc(n*sizeof(int));
+/**
+ * Solve with heldKarp_iter, then with the multi-process Held-Karp algorithm,
+ * and print the compute and communication times of each layer
+ */
+void solveDistributed(int n, const costProvider* cost, int nbWorkers){
+    int** dp = allocRows(n);
+    int** succ = allocRows(n);
+    if (dp == NULL || succ == NULL){
+        printf("Not enough memory for the DP tables.\n");
+        freeRows(n, dp);
+        freeRows(n, succ);
+        return;
     }
-    for (int i=0; i<n; i++){
-        cost[i][i] = max*max;
-        for (int j=i+1; j<n; j++){
-            cost[i][j] = (int)sqrt((x[i]-x[j])*(x[i]-x[j]) + (y[i]-y[j])*(y[i]-y[j]));
-            cost[j][i] = cost[i][j];
-        }
+    double t = wallTime();
+    int ds = heldKarp_iter(n, cost, dp, succ);
+    double ts = wallTime() - t;
+    freeRows(n, succ);
+    int tour[n];
+    hkDistStats stats;
+    t = wallTime();
+    int dd = heldKarp_distributed(n, cost, nbWorkers, dp, tour, &stats);
+    double td = wallTime() - t;
+    freeRows(n, dp);
+    if (dd < 0){
+        printf("The worker processes cannot be started, or a socket failed.\n");
+        return;
     }
-    return cost;
+
+    printf("%3s %12s %12s %12s %12s\n", "k", "subsets", "sent (MB)", "compute (s)", "comm (s)");
+    for (int k=1; k<n-1; k++)
+        printf("%3d %12lu %12.2f %12.4f %12.4f\n", k, (unsigned long)binom[n-1][k], stats.bytes[k]/1e6,
+               stats.compute[k], stats.communication[k]);
+    printf("Length of the smallest hamiltonian circuit (heldKarp_iter) = %d; wall time = %.3fs\n", ds, ts);
+    printf("Length of the smallest hamiltonian circuit (%d processes) = %d; wall time = %.3fs; speedup = %.2f\n",
+           nbWorkers, dd, td, td > 0 ? ts/td : 0);
+    if (ds != dd) printf("    - MISMATCH between heldKarp_iter and the multi-process solver\n");
+    printGap(dd);
+    printf("Circuit :");
+    for (int k=0; k<n; k++) printf(" %d", tour[k]);
+    printf(" 0\n");
 }
 
-__uint64_t nb_calls = 0; // number of calls to computeD
-__uint64_t nb_states = 0;          // nb of states in the memoisation table
+/**
+ * Solve with the low-memory Held-Karp algorithm and report its memory usage
+ */
+void solveCompact(int n, const costProvider* cost){
+    hkCompact* c = hkCompactCreate(n, cost);
+    if (c == NULL){
+        printf("Not enough memory for the successor table.\n");
+        return;
+    }
+    double t = wallTime();
+    int d = heldKarp_compact(n, cost, c);
+    t = wallTime() - t;
+    if (d < 0){
+        printf("Not enough memory for a cost layer.\n");
+        hkCompactFree(c);
+        return;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Length of the smallest hamiltonian circuit (low memory) = %d; wall time = %.3fs\n", d, t);
+    printf("    - Upper bound = %d; cost cells of %d bytes; successors on 5 bits\n", c->upperBound, c->costBytes);
+    printf("    - Peak table memory = %.1f MB (dp + succ of heldKarp_iter: %.1f MB)\n",
+           c->peakTableBytes/1e6, 2.0*sizeof(int)*n*(double)((size_t)1 << (n-1))/1e6);
+    printf("    - Peak resident memory = %.1f MB\n", usage.ru_maxrss/1e3);
+    printGap(d);
+    printTour_compact(c);
+    hkCompactFree(c);
+}
 
 /**
- * Held-Karp algorithm for the Travelling Salesman Problem
+ * Solve with the out-of-core Held-Karp algorithm, the layers being streamed to files of dir
  */
-int computeD(int i, set s, int n, int** cost){
-    nb_calls += 1;
-    // Preconditions: isIn(i,s) = false and isIn(0,s) = false
-    // Postrelation: return the cost of the smallest path that starts from i, visits each vertex of s exactly once, and ends on 0
-    if (isEmpty(s)) return cost[i][0];
-    int min = INT_MAX;
-    for (int j=1; j<n; j++){
-        if (isIn(j,s)){
-            int d = computeD(j, removeElement(s,j), n, cost);
-            if (cost[i][j] + d < min) min = cost[i][j] + d;
-        }
+void solveDisk(int n, const costProvider* cost, const char* dir){
+    hkDisk* dk = hkDiskCreate(n, dir);
+    if (dk == NULL){
+        printf("Cannot create the layer files in %s.\n", dir);
+        return;
+    }
+    double t = wallTime();
+    int d = heldKarp_disk(n, cost, dk, NULL);
+    t = wallTime() - t;
+    if (d < 0){
+        printf("A layer cannot be written to or mapped from %s.\n", dir);
+        hkDiskFree(dk);
+        return;
     }
-    return min;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("Length of the smallest hamiltonian circuit (out of core) = %d; wall time = %.3fs\n", d, t);
+    printf("    - Written = %.1f MB; mapped = %.1f MB; peak disk usage = %.1f MB (dp + succ of heldKarp_iter: %.1f MB)\n",
+           dk->bytesWritten/1e6, dk->bytesMapped/1e6, dk->peakDiskBytes/1e6, 2.0*sizeof(int)*n*(double)((size_t)1 << (n-1))/1e6);
+    printf("    - Write buffers = %.1f MB; peak resident memory = %.1f MB\n", 2*dk->bufferBytes/1e6, usage.ru_maxrss/1e3);
+    printGap(d);
+    printTour_disk(dk);
+    hkDiskFree(dk);
 }
 
 /**
- * computeD version with memoisation
+ * Solve with the bidirectional Held-Karp algorithm, and check its length with heldKarp_iter up to 22 vertices
  */
-int computeD_memo(int i, set s, int n, int** cost, int** memo){
-    nb_calls += 1;
-    // Preconditions: isIn(i,s) = false and isIn(0,s) = false
-    // Postrelation: return the cost of the smallest path that starts from i, visits each vertex of s exactly once, and ends on 0
-    if (isEmpty(s)) return cost[i][0];
-    if (memo[i][s] != 0) return memo[i][s];
-    int min = INT_MAX;
-    for (int j=1; j<n; j++){
-        if (isIn(j,s)){
-            int d = computeD_memo(j, removeElement(s,j), n, cost, memo);
-            if (cost[i][j] + d < min) min = cost[i][j] + d;
+void solveBidir(int n, const costProvider* cost){
+    hkBidir* b = hkBidirCreate(n);
+    if (b == NULL){
+        printf("Not enough memory for the successor table.\n");
+        return;
+    }
+    double t = wallTime();
+    int d = heldKarp_bidir(n, cost, b);
+    t = wallTime() - t;
+    if (d < 0){
+        printf("Not enough memory for a cost layer.\n");
+        hkBidirFree(b);
+        return;
+    }
+    printf("Length of the smallest hamiltonian circuit (bidirectional) = %d; wall time = %.3fs\n", d, t);
+    printf("    - Layers 0 to %d of %d; peak table memory = %.1f MB (dp + succ of heldKarp_iter: %.1f MB)\n",
+           b->half, n-1, b->peakTableBytes/1e6, 2.0*sizeof(int)*n*(double)((size_t)1 << (n-1))/1e6);
+    if (n <= 22){
+        int** dp = allocRows(n);
+        int** succ = allocRows(n);
+        if (dp != NULL && succ != NULL){
+            t = wallTime();
+            int ref = heldKarp_iter(n, cost, dp, succ);
+            t = wallTime() - t;
+            printf("    - heldKarp_iter = %d; wall time = %.3fs%s\n", ref, t, ref != d ? "  MISMATCH" : "");
         }
+        freeRows(n, dp);
+        freeRows(n, succ);
     }
-    memo[i][s] = min;
-    return min;
+    printGap(d);
+    int tour[n];
+    tour_bidir(b, tour);
+    printf("Circuit :");
+    for (int k=0; k<n; k++) printf(" %d", tour[k]);
+    printf(" 0\n");
+    hkBidirFree(b);
 }
 
-int heldKarp_iter(int n, int **cost, int **dp, int **succ){
-    int FULL = 1 << (n-1); // stop when 2^(n-1) - 1 states are reached
-    // initialize the dp and succ tables
-    for(int i=0; i<n; ++i){
-        for(int S=0; S<FULL; ++S){
-            dp[i][S]   = INT_MAX;
-            succ[i][S] = -1;
-        }
+/**
+ * Compare the cycles per state of heldKarp_iter and of the scalar and vector kernels of heldKarp_simd
+ */
+void solveSimd(int n, const costProvider* cost){
+    double nbCells = (double)(n-1) * ((size_t)1 << (n-2)); // number of cells (i,S) with i not in S
+    int** dp = allocRows(n);
+    int** succ = allocRows(n);
+    hkTable* table = hkTableCreate(n, HK_LAYOUT_SMAJOR);
+    if (dp == NULL || succ == NULL || table == NULL){
+        printf("Not enough memory for the DP tables.\n");
+        freeRows(n, dp);
+        freeRows(n, succ);
+        hkTableFree(table);
+        return;
     }
+    // touch the table first, so that the first kernel does not pay the page faults
+    memset(table->dp, 0, table->nbCells*sizeof(int));
+    memset(table->succ, 0, table->nbCells*sizeof(int));
+    uint64_t c = cycleCount();
+    int ref = heldKarp_iter(n, cost, dp, succ);
+    c = cycleCount() - c;
+    printf("%-28s length = %d; cycles/state = %.2f\n", "heldKarp_iter:", ref, c/nbCells);
+    printGap(ref);
+    freeRows(n, dp);
+    freeRows(n, succ);
 
-    // base case: start from depot (0) and go to the first vertex
-    for(int i=1; i<n; ++i) dp[i][0] = cost[i][0];
-
-    // compute the cost of all paths
-    for(int S=1; S<FULL; ++S){ // all subsets of vertices
-        for(int i=1; i<n; ++i){
-            if(isIn(i,S)) continue; // i must not be in S
-            int best = INT_MAX;
-            int bestj = -1;
-            for(int j=1; j<n; ++j){
-                if(!isIn(j,S)) continue; // j must be in S
-                int S2 = removeElement(S,j);
-                int val = dp[j][S2];
-                if(val==INT_MAX) continue; // no path from j to S2
-                int alt = cost[i][j] + val;
-                if(alt < best){
-                    best  = alt;
-                    bestj = j;
-                }
-            }
-            dp[i][S] = best;
-            succ[i][S] = bestj;
-            nb_states++;
+    hkKernel kernels[] = {HK_KERNEL_SCALAR, HK_KERNEL_VECTOR};
+    for (int k=0; k<2; k++){
+        c = cycleCount();
+        int d = heldKarp_simd(n, cost, table, kernels[k]);
+        c = cycleCount() - c;
+        if (d < 0){
+            printf("Not enough memory for the transposed costs.\n");
+            hkTableFree(table);
+            return;
         }
+        char name[64];
+        sprintf(name, "heldKarp_simd (%s):", kernels[k] == HK_KERNEL_SCALAR ? "scalar" : hkVectorIsa());
+        printf("%-28s length = %d; cycles/state = %.2f%s\n", name, d, c/nbCells, d != ref ? "  MISMATCH" : "");
     }
+    printTour_table(table);
+    hkTableFree(table);
+}
 
-    // return to depot (0)
-    int best = INT_MAX;
-    int bestj = -1; 
-    int ALL = FULL-1; // 2^(n-1) - 1, a full set 111...111 with n-1 bits
-    for(int j=1; j<n; ++j){
-        int val = dp[j][removeElement(ALL,j)];
-        if(val==INT_MAX) continue;
-        int alt = cost[0][j] + val;
-        if(alt < best){
-            best  = alt;
-            bestj = j;
-        }
+void printMemoStats(const memoTable* memo){
+    // Postcondition: print the backend, occupancy and probe statistics of a memoisation table
+    printf("    - Memoisation table (%s): %.1f MB", memoKindName(memo->kind), memoBytes(memo)/1e6);
+    if (memo->kind == MEMO_SPARSE)
+        printf("; %lu states; load factor = %.2f", (unsigned long)memoCount(memo), memoLoadFactor(memo));
+    printf("; average probe length = %.3f; max = %lu\n",
+           memo->lookups > 0 ? (double)memo->probes/memo->lookups : 0, (unsigned long)memo->maxProbe);
+}
+
+/**
+ * Solve with the memoised DP pruned by lower bounds and by the length of a 2-opt local optimum
+ */
+void solvePruned(int n, const costProvider* cost, memoKind kind){
+    memoTable* memo = memoCreate(kind, n);
+    if (memo == NULL){
+        printf("Not enough memory for the memoisation table.\n");
+        return;
     }
-    succ[0][ALL] = bestj;
-    return best;
+    int sol[n];
+    bbStats stats;
+    double t = wallTime();
+    int d = solveBounded(n, cost, memo, sol, &stats);
+    t = wallTime() - t;
+    printf("Length of the smallest hamiltonian circuit (with pruning) = %d; wall time = %.3fs\n", d, t);
+    printf("    - States expanded = %lu; pruned = %lu; reused from the table = %lu\n",
+           (unsigned long)stats.expanded, (unsigned long)stats.pruned, (unsigned long)stats.reused);
+    printf("    - Expanded states / reachable states = %.6g\n", stats.expanded / ((double)(n-1) * ldexp(1, n-2) + 1));
+    printMemoStats(memo);
+    printGap(d);
+    printf("Circuit :");
+    for (int k=0; k<n; k++) printf(" %d", sol[k]);
+    printf(" 0\n");
+    memoFree(memo);
 }
 
 /**
- * Print the tour, iterate over the successors
- * starting from the depot (0) and going to the first vertex
- * and then to the next vertex, etc.
- * The tour ends when we return to the depot (0)
+ * Solve with the beam Held-Karp algorithm, keeping the width best states of each layer
  */
-void printTour(int n, int **succ){
-    int S = (1<<(n-1)) - 1;   // full set {1,2,...,n-1}
-    int i = 0;
-    printf("Circuit : 0");
-    for(int k=0; k<n-1; ++k){
-        int j = succ[i][S];
-        if(j==-1){ printf(" ?"); break; }
-        printf(" %d", j);
-        S = removeElement(S, j);
-        i = j;
+void solveBeam(int n, const costProvider* cost, int width){
+    hkBeam* b = hkBeamCreate(n, width);
+    int* tour = (int*) malloc(n*sizeof(int));
+    if (b == NULL || tour == NULL){
+        printf("Not enough memory for the beam tables.\n");
+        hkBeamFree(b);
+        free(tour);
+        return;
     }
+    beamStats stats;
+    double t = wallTime();
+    int d = heldKarp_beam(n, cost, b, tour, &stats);
+    t = wallTime() - t;
+    printf("Length of the hamiltonian circuit (beam of width %d) = %d; wall time = %.3fs\n", width, d, t);
+    printf("    - Candidate states = %lu; merged = %lu; evicted = %lu\n",
+           (unsigned long)stats.generated, (unsigned long)stats.merged, (unsigned long)stats.evicted);
+    printf("    - Table memory = %.1f MB\n", hkBeamBytes(b)/1e6);
+    printGap(d);
+    printf("Circuit :");
+    for (int k=0; k<n; k++) printf(" %d", tour[k]);
     printf(" 0\n");
+    free(tour);
+    hkBeamFree(b);
+}
+
+void printBatchStats(const batchServer* s, long faults){
+    // side effect: print on stderr the throughput of s and the page faults since the server started
+    const batchStats* st = &s->stats;
+    fprintf(stderr, "%lu instances (%lu invalid) in %lu batches; %.3fs; %.0f instances/s\n",
+            (unsigned long)st->instances, (unsigned long)st->invalid, (unsigned long)st->batches, st->seconds,
+            st->seconds > 0 ? st->instances/st->seconds : 0);
+    fprintf(stderr, "    - Largest instance = %d vertices; tables = %.1f MB (%lu allocations); minor page faults = %ld\n",
+            st->nmax, batchTableBytes(s)/1e6, (unsigned long)batchGrowths(s), faults);
+}
+
+/**
+ * Answer the instances of stdin on stdout or, if socketPath is not NULL, those of each connection
+ * accepted on the Unix-domain socket socketPath, and print the throughput on stderr
+ */
+void serveInstances(const char* socketPath, int nbThreads){
+    batchServer* s = batchServerCreate(nbThreads);
+    if (s == NULL){
+        printf("Not enough memory for the batch solver.\n");
+        return;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long faults = usage.ru_minflt;
+    if (socketPath == NULL){
+        if (batchServe(s, STDIN_FILENO, STDOUT_FILENO) < 0) fprintf(stderr, "The answers cannot be written.\n");
+        getrusage(RUSAGE_SELF, &usage);
+        printBatchStats(s, usage.ru_minflt - faults);
+        batchServerFree(s);
+        return;
+    }
+    int fd = batchListen(socketPath);
+    if (fd < 0){
+        printf("Cannot listen on %s.\n", socketPath);
+        batchServerFree(s);
+        return;
+    }
+    fprintf(stderr, "Listening on %s\n", socketPath);
+    while (true){
+        int conn = accept(fd, NULL, NULL);
+        if (conn < 0) continue;
+        if (batchServe(s, conn, conn) < 0) fprintf(stderr, "The answers cannot be written.\n");
+        close(conn);
+        getrusage(RUSAGE_SELF, &usage);
+        printBatchStats(s, usage.ru_minflt - faults);
+    }
+}
+
+long anonHugeKiB(void){
+    // Postcondition: return the kB of anonymous memory of the process mapped with transparent huge pages, or -1 if unknown
+    FILE* f = fopen("/proc/self/smaps_rollup", "r");
+    if (f == NULL) return -1;
+    char line[256];
+    long kib = -1;
+    while (fgets(line, sizeof(line), f) != NULL)
+        if (sscanf(line, "AnonHugePages: %ld kB", &kib) == 1) break;
+    fclose(f);
+    return kib;
+}
+
+void printPageStats(long faults, int fallbacks){
+    // side effect: print the page faults of the DP, and the memory backed by huge pages
+    printf("    - Minor page faults during the DP = %ld\n", faults);
+    long kib = anonHugeKiB();
+    if (kib >= 0) printf("    - Memory on transparent huge pages = %.1f MB\n", kib/1024.0);
+    if (fallbacks > 0) printf("    - %d blocks on transparent huge pages instead of explicit ones (empty hugetlb pool)\n", fallbacks);
 }
 
 int main(int argc, char** argv){
     int n, d;
+    initBinom();
+
+    // Options: -b nmin:nmax benchmarks the DP table layouts for n in [nmin,nmax]
+    //          -t threads solves with the layer-parallel DP
+    //          -j processes solves with the multi-process DP, the layers being exchanged over local sockets
+    //          -c solves with the low-memory DP
+    //          --disk dir solves with the out-of-core DP, streaming the layers to files of dir
+    //          --bidirectional solves with the meet-in-the-middle DP (symmetric costs)
+    //          -v compares the scalar and vectorised DP kernels
+    //          -p solves with the memoised DP pruned by bounds
+    //          -w width solves with the beam DP keeping width states per layer (heuristic, any number of vertices)
+    //          -m dense|sparse chooses the memoisation table of the top-down solvers
+    //             (dense up to DENSE_MAX_VERTICES vertices, sparse beyond, by default)
+    //          -d matrix|coords stores the costs in a matrix (default) or computes them from the coordinates
+    //          --batch answers the instances of stdin (one per line: n x1 y1 ... xn yn) on stdout, with tables reused
+    //                  from one instance to the next (-t threads solves several instances at a time)
+    //          --listen path does the same for each connection to the Unix-domain socket path
+    //          --instance file solves the TSPLIB instance of file instead of a random one (n is then not given),
+    //                     and reports the gap to the optimal tour of file.opt.tour, if there is one
+    //          --pages small|transparent|explicit chooses the pages of the dp and succ rows of the default solver
+    //                  (transparent huge pages by default; explicit ones need a pool in /proc/sys/vm/nr_hugepages)
+    //          --report file writes the instrumentation report in file instead of stderr (make INSTRUMENT=1 or 2)
+    int benchMin = 0, benchMax = 0;
+    int nbThreads = 0;
+    int nbProcesses = 0;
+    int memoChoice = -1;
+    costKind storage = COST_MATRIX16;
+    bool compact = false;
+    bool simd = false;
+    bool pruned = false;
+    int beamWidth = 0;
+    const char* instanceFile = NULL;
+    const char* reportFile = NULL;
+    const char* diskDir = NULL;
+    bool bidir = false;
+    bool batch = false;
+    const char* socketPath = NULL;
+    arenaPages pages = ARENA_PAGES_TRANSPARENT;
+    static struct option longOptions[] = {
+        {"instance", required_argument, NULL, 'I'},
+        {"report", required_argument, NULL, 'P'},
+        {"disk", required_argument, NULL, 'D'},
+        {"bidirectional", no_argument, NULL, 'M'},
+        {"batch", no_argument, NULL, 'B'},
+        {"listen", required_argument, NULL, 'L'},
+        {"pages", required_argument, NULL, 'G'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:t:j:cvpm:d:w:", longOptions, NULL)) != -1){
+        switch (opt){
+            case 'b':
+                if (sscanf(optarg, "%d:%d", &benchMin, &benchMax) != 2 || benchMin < 2 || benchMax > DENSE_MAX_VERTICES || benchMin > benchMax){
+                    printf("The benchmark range must be nmin:nmax with 2 <= nmin <= nmax <= %d.\n", DENSE_MAX_VERTICES);
+                    return 0;
+                }
+                break;
+            case 't':
+                nbThreads = atoi(optarg);
+                if (nbThreads < 1){
+                    printf("The number of threads must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'j':
+                nbProcesses = atoi(optarg);
+                if (nbProcesses < 1){
+                    printf("The number of processes must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'c':
+                compact = true;
+                break;
+            case 'v':
+                simd = true;
+                break;
+            case 'p':
+                pruned = true;
+                break;
+            case 'w':
+                beamWidth = atoi(optarg);
+                if (beamWidth < 1){
+                    printf("The width of the beam must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "dense") == 0) memoChoice = MEMO_DENSE;
+                else if (strcmp(optarg, "sparse") == 0) memoChoice = MEMO_SPARSE;
+                else {
+                    printf("The memoisation table must be dense or sparse.\n");
+                    return 0;
+                }
+                break;
+            case 'd':
+                if (strcmp(optarg, "matrix") == 0) storage = COST_MATRIX16;
+                else if (strcmp(optarg, "coords") == 0) storage = COST_COORDS;
+                else {
+                    printf("The costs must be stored in a matrix or computed from the coords.\n");
+                    return 0;
+                }
+                break;
+            case 'I':
+                instanceFile = optarg;
+                break;
+            case 'P':
+                reportFile = optarg;
+                break;
+            case 'D':
+                diskDir = optarg;
+                break;
+            case 'M':
+                bidir = true;
+                break;
+            case 'B':
+                batch = true;
+                break;
+            case 'L':
+                socketPath = optarg;
+                break;
+            case 'G':
+                if (strcmp(optarg, "small") == 0) pages = ARENA_PAGES_SMALL;
+                else if (strcmp(optarg, "transparent") == 0) pages = ARENA_PAGES_TRANSPARENT;
+                else if (strcmp(optarg, "explicit") == 0) pages = ARENA_PAGES_EXPLICIT;
+                else {
+                    printf("The pages must be small, transparent or explicit.\n");
+                    return 0;
+                }
+                break;
+            default:
+                printf("Usage: %s [-b nmin:nmax] [-t threads] [-j processes] [-c] [--disk dir] [--bidirectional] [-v] [-p] [-w width] [-m dense|sparse] [-d matrix|coords]\n"
+                       "       [--pages small|transparent|explicit] [--report file] [number of vertices | --instance file | --batch | --listen path]\n", argv[0]);
+                return 0;
+        }
+    }
+
+    // each of these options selects a solver: reject their combinations rather than ignore all but one
+    // (-t also gives the number of threads of --batch and --listen)
+    bool serve = batch || socketPath != NULL;
+    int nbModes = (benchMin > 0) + (nbThreads > 0 && !serve) + (nbProcesses > 0) + compact + (diskDir != NULL) + bidir + simd + pruned
+                  + (beamWidth > 0) + serve;
+    if (nbModes > 1){
+        printf("The options -b, -t, -j, -c, --disk, --bidirectional, -v, -p, -w and --batch|--listen cannot be combined.\n");
+        return 0;
+    }
+    if (benchMin > 0){
+        benchLayouts(benchMin, benchMax);
+        return 0;
+    }
+
+    instrumentInit(reportFile);
+    if (serve){
+        serveInstances(socketPath, nbThreads > 0 ? nbThreads : 1);
+        return 0;
+    }
 
-    // Get parameters either from command line or from user
-    if (argc > 1) {
-        n = atoi(argv[1]);
+    // Get parameters either from command line, from the instance file, or from user
+    tsplibInstance* inst = NULL;
+    if (instanceFile != NULL){
+        if ((inst = tsplibLoad(instanceFile)) == NULL){
+            printf("The instance cannot be loaded.\n");
+            return 0;
+        }
+        n = inst->n;
+    } else if (optind < argc) {
+        n = atoi(argv[optind]);
     } else {
         printf("Number of vertices: "); fflush(stdout);
         if (scanf("%d", &n) != 1) {
@@ -213,12 +638,82 @@ int main(int argc, char** argv){
             return 0;
         }
     }
-    if ((n > 32) || (n < 1)){
-        printf("The number of vertices must be an integer value in [1,32].\n");
+    if (beamWidth > 0 && n < 2){
+        printf("The beam DP needs at least 2 vertices.\n");
+        tsplibFree(inst);
+        return 0;
+    }
+    if ((n > SET_MAX_VERTICES && beamWidth == 0) || (n < 1)){
+        // the sets of the beam DP are bit vectors of any length
+        printf("The number of vertices must be an integer value in [1,%d].\n", SET_MAX_VERTICES);
+        tsplibFree(inst);
         return 0;
     }
 
-    int** cost = createCost(n);
+    memoKind kind = (memoChoice >= 0) ? (memoKind)memoChoice : (n <= DENSE_MAX_VERTICES ? MEMO_DENSE : MEMO_SPARSE);
+    costProvider* cost = (inst != NULL) ? tsplibCost(inst, storage) : createCost(n, storage);
+    tsplibFree(inst);
+    if (cost == NULL){
+        printf("Not enough memory for the costs.\n");
+        return 0;
+    }
+    if (instanceFile != NULL){
+        printf("Instance %s: %d vertices\n", instanceFile, n);
+        optimum = tsplibOptimum(instanceFile, cost);
+        if (optimum >= 0) printf("Length of the optimal tour = %d\n", optimum);
+    }
+    if (beamWidth > 0){
+        solveBeam(n, cost, beamWidth);
+        costFree(cost);
+        return 0;
+    }
+    if (n > DENSE_MAX_VERTICES && (!pruned || kind == MEMO_DENSE)){
+        // only the pruned solver with a sparse memoisation table goes beyond
+        printf("The DP tables indexed by subsets are limited to %d vertices.\n", DENSE_MAX_VERTICES);
+        costFree(cost);
+        return 0;
+    }
+    if (nbThreads > 0){
+        if (n < 2) printf("The layer-parallel DP needs at least 2 vertices.\n");
+        else solveParallel(n, cost, nbThreads);
+        costFree(cost);
+        return 0;
+    }
+    if (nbProcesses > 0){
+        if (n < 2) printf("The multi-process DP needs at least 2 vertices.\n");
+        else solveDistributed(n, cost, nbProcesses);
+        costFree(cost);
+        return 0;
+    }
+    if (compact){
+        if (n < 2) printf("The low-memory DP needs at least 2 vertices.\n");
+        else solveCompact(n, cost);
+        costFree(cost);
+        return 0;
+    }
+    if (diskDir != NULL){
+        if (n < 2) printf("The out-of-core DP needs at least 2 vertices.\n");
+        else solveDisk(n, cost, diskDir);
+        costFree(cost);
+        return 0;
+    }
+    if (bidir){
+        if (n < 2) printf("The bidirectional DP needs at least 2 vertices.\n");
+        else solveBidir(n, cost);
+        costFree(cost);
+        return 0;
+    }
+    if (simd){
+        if (n < 2) printf("The vectorised DP needs at least 2 vertices.\n");
+        else solveSimd(n, cost);
+        costFree(cost);
+        return 0;
+    }
+    if (pruned){
+        solvePruned(n, cost, kind);
+        costFree(cost);
+        return 0;
+    }
     set s = createSet(n); // s contains all integer values ranging between 1 and n-1
     clock_t t = clock();
     // int d = computeD(0, s, n, cost);
@@ -230,39 +725,64 @@ int main(int argc, char** argv){
     // Version with memoisation
     nb_calls = 0;
     t = clock();
-    int** memo = (int**) malloc(n*sizeof(int*));
     /**
      * Allocate the memoisation table
-     * There are n rows (one for each vertex).
-     * The number of columns is 2^(n-1) (one for each subset of vertices).
-     * The size of the memoisation table is thus n * 2^(n-1) integers.
+     * Dense: n rows (one for each vertex) of 2^(n-1) columns (one for each subset of vertices),
+     * mapped on demand, so that the pages of states never visited are never touched.
+     * Sparse: a hash table holding only the states visited.
      */
-    for (int i=0; i<n; i++){
-        memo[i] = (int*)malloc((pow(2, n - 1))*sizeof(int));
-        for (int j=0; j<(pow(2, n - 1)); j++) memo[i][j] = 0;
+    memoTable* memo = memoCreate(kind, n);
+    if (memo == NULL){
+        printf("Not enough memory for the memoisation table.\n");
+        costFree(cost);
+        return 0;
     }
     printf("Alloc time = %.3fs\n", ((double) (clock() - t)) / CLOCKS_PER_SEC);
 
     t = clock();
+    INSTR_START(tSweep);
+    INSTR_PERF_BEGIN();
     d = computeD_memo(0, s, n, cost, memo);
+    INSTR_PERF_END();
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
     duration = ((double) (clock() - t)) / CLOCKS_PER_SEC;
     printf("Length of the smallest hamiltonian circuit (with memoisation) = %d; CPU time = %.3fs\n", d, duration);
     printf("    - Number of calls to computeD_memo = %lu\n", nb_calls);
+    printMemoStats(memo);
+    printGap(d);
+    memoFree(memo);
 
     // Version with dynamic programming
     nb_calls = 0;
-    t = clock();
-    int **dp = (int**) malloc(n*sizeof(int*));
-    int **succ = (int**) malloc(n*sizeof(int*));
-    for (int i=0; i<n; i++){
-        dp[i] = (int*)malloc((pow(2, n - 1))*sizeof(int));
-        succ[i] = (int*)malloc((pow(2, n - 1))*sizeof(int));
+    /**
+     * Allocate the dp and succ tables: n rows of 2^(n-1) cells each, taken from an arena of huge pages
+     * and zero-filled by the kernel on first access, so that the allocation itself touches no page
+     */
+    double wall = wallTime();
+    int **dp = allocRowsPages(n, pages);
+    int **succ = allocRowsPages(n, pages);
+    if (dp == NULL || succ == NULL){
+        printf("Not enough memory for the DP tables.\n");
+        freeRows(n, dp);
+        freeRows(n, succ);
+        costFree(cost);
+        return 0;
     }
+    printf("Alloc time = %.6fs (%s pages)\n", wallTime() - wall, arenaPagesName(pages));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long faults = usage.ru_minflt;
+    t = clock();
     d = heldKarp_iter(n, cost, dp, succ);
     duration = ((double) (clock() - t)) / CLOCKS_PER_SEC;
+    getrusage(RUSAGE_SELF, &usage);
     printf("Length of the smallest hamiltonian circuit (with dynamic programming) = %d; CPU time = %.3fs\n", d, duration);
     printf("    - Number of states in the memoisation table = %lu\n", nb_states);
+    printPageStats(usage.ru_minflt - faults, rowsArena(dp)->fallbacks + rowsArena(succ)->fallbacks);
+    printGap(d);
     printTour(n, succ);
+    freeRows(n, dp);
+    freeRows(n, succ);
 
     // for (n = 1; n < 10; n++){
     //     nb_calls = 0;
@@ -271,11 +791,8 @@ int main(int argc, char** argv){
     //     printf("n = %d; Number of calls to computeD = %lu\n", n, nb_calls);
     // }
 
-    // Free the cost matrix
-    for (int i=0; i<n; i++){
-        free(cost[i]);
-    }
-    free(cost);
+    // Free the costs
+    costFree(cost);
     
     return 0;
 }
@@ -0,0 +1,122 @@
+/*
+ Arena allocator for DP storage
+
+ Memory is obtained from the kernel with mmap in large blocks and handed out by bumping a
+ pointer. Pages of a fresh mapping are zero-filled on first access, so tables whose empty
+ value is 0 need no fill loop, and pages that are never touched never become resident.
+ Everything is given back at once by arenaFree; arenaRelease returns the physical pages of a
+ region that is not needed anymore while keeping its addresses reserved.
+ With huge pages, blocks are multiples of 2 MB starting on a 2 MB boundary, so that each 2 MB of
+ a table is a single TLB entry and a single page fault instead of 512. Transparent huge pages
+ are requested with madvise (the kernel may still use base pages); explicit ones come from the
+ pool reserved in /proc/sys/vm/nr_hugepages and are used when they can be mapped.
+ Pages are placed on the NUMA node of the thread that touches them first: the arena only
+ reserves addresses, so the threads that compute a table should be the first to write it.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "arena.h"
+
+#define ALIGNMENT 64 // cache line
+
+static size_t roundUp(size_t x, size_t m){
+    return (x + m - 1) / m * m;
+}
+
+static arenaBlock* mapBlock(arena* a, size_t size){
+    // Precondition: size is a multiple of HUGE_PAGE_SIZE if a uses huge pages
+    void* p = MAP_FAILED;
+    if (a->pages == ARENA_PAGES_EXPLICIT){
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) a->fallbacks++;
+    }
+    if (p == MAP_FAILED && a->pages != ARENA_PAGES_SMALL){
+        // map one more huge page, then cut what lies before the first 2 MB boundary and after the block
+        char* q = (char*) mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (q == MAP_FAILED) return NULL;
+        char* start = (char*) roundUp((uintptr_t)q, HUGE_PAGE_SIZE);
+        if (start > q) munmap(q, start - q);
+        if (q + HUGE_PAGE_SIZE > start) munmap(start + size, q + HUGE_PAGE_SIZE - start);
+        madvise(start, size, MADV_HUGEPAGE);
+        p = start;
+    }
+    if (p == MAP_FAILED) p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+    arenaBlock* b = (arenaBlock*) p;
+    b->next = NULL;
+    b->size = size;
+    b->used = roundUp(sizeof(arenaBlock), ALIGNMENT);
+    return b;
+}
+
+static size_t pageSize(const arena* a){
+    // Postcondition: return the granularity of the blocks of a
+    return (a->pages == ARENA_PAGES_SMALL) ? (size_t)sysconf(_SC_PAGESIZE) : HUGE_PAGE_SIZE;
+}
+
+arena* arenaCreate(size_t blockSize){
+    // Postcondition: return an empty arena of base pages whose blocks are (at least) blockSize bytes, or NULL
+    return arenaCreatePages(blockSize, ARENA_PAGES_SMALL);
+}
+
+arena* arenaCreatePages(size_t blockSize, arenaPages pages){
+    // Postcondition: return an empty arena of the given pages whose blocks are (at least) blockSize bytes, or NULL
+    arena* a = (arena*) malloc(sizeof(arena));
+    if (a == NULL) return NULL;
+    a->blocks = NULL;
+    a->pages = pages;
+    a->fallbacks = 0;
+    a->blockSize = roundUp(blockSize, pageSize(a));
+    a->mapped = 0;
+    return a;
+}
+
+const char* arenaPagesName(arenaPages pages){
+    switch (pages){
+        case ARENA_PAGES_SMALL: return "small";
+        case ARENA_PAGES_TRANSPARENT: return "transparent";
+        case ARENA_PAGES_EXPLICIT: return "explicit";
+    }
+    return "?";
+}
+
+void* arenaAlloc(arena* a, size_t bytes){
+    // Postcondition: return a zero-filled region of bytes bytes aligned on ALIGNMENT, or NULL
+    bytes = roundUp(bytes, ALIGNMENT);
+    arenaBlock* b = a->blocks;
+    if (b == NULL || b->used + bytes > b->size){
+        size_t header = roundUp(sizeof(arenaBlock), ALIGNMENT);
+        size_t size = (bytes + header > a->blockSize) ? roundUp(bytes + header, pageSize(a)) : a->blockSize;
+        b = mapBlock(a, size);
+        if (b == NULL) return NULL;
+        b->next = a->blocks;
+        a->blocks = b;
+        a->mapped += size;
+    }
+    void* p = (char*)b + b->used;
+    b->used += bytes;
+    return p;
+}
+
+void arenaRelease(arena* a, void* p, size_t bytes){
+    // Postcondition: the whole pages inside [p, p+bytes) are given back to the kernel (and read as 0 again)
+    size_t page = pageSize(a);
+    uintptr_t first = roundUp((uintptr_t)p, page);
+    uintptr_t last = ((uintptr_t)p + bytes) / page * page;
+    if (last > first) madvise((void*)first, last - first, MADV_DONTNEED);
+}
+
+void arenaFree(arena* a){
+    if (a == NULL) return;
+    arenaBlock* b = a->blocks;
+    while (b != NULL){
+        arenaBlock* next = b->next;
+        munmap(b, b->size);
+        b = next;
+    }
+    free(a);
+}
@@ -0,0 +1,175 @@
+/*
+ Balas-Simonetti neighbourhood: best tour in which no vertex moves by k positions or more
+
+ The vertices are numbered by their positions 0..n-1 in the current tour (read from an offset), and
+ the new tour starts from vertex 0 and must visit i before j whenever j >= i+k. This neighbourhood
+ contains k^n/e tours, and its best tour is found by a DP over the positions of the new tour:
+ when the new tour has been built up to some vertex, let f (the frontier) be the smallest vertex not
+ visited yet. All vertices before f have been visited, no vertex beyond f+k-1 has, and the visited
+ ones in between are a subset S of {1,...,k-1} (element e for vertex f+e), stored as a set of the
+ Held-Karp solvers. The last vertex visited is f+d-k, with d in [0,2k-1]. A state (f,S,d) has at most
+ k successors: visit f, which moves the frontier, or visit one of the k-1 vertices f+e not in S.
+ The time is O(n k^2 2^k) and the DP values only need the k+1 frontiers ahead of the current one,
+ kept in a ring; the last vertex of the previous state is kept for every state, to rebuild the tour.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "balasSimonetti.h"
+#include "timer.h"
+
+size_t bsTableBytes(int n, int k){
+    // Postcondition: return the number of bytes of a table of width k for n vertices
+    size_t nbStates = ((size_t)1 << (k-1)) * 2*k;
+    return (size_t)(n+1)*nbStates*sizeof(int8_t) + (size_t)(k+1)*nbStates*sizeof(int32_t) + n*sizeof(int);
+}
+
+int bsMaxWidth(int n){
+    // Postcondition: return the largest width k <= BS_MAX_WIDTH whose table for n vertices fits in
+    //                BS_MAX_TABLE_BYTES (1 if there is none)
+    int k = BS_MAX_WIDTH;
+    while (k >= 2 && bsTableBytes(n, k) > BS_MAX_TABLE_BYTES) k--;
+    return k < 2 ? 1 : k;
+}
+
+bsTable* bsCreate(int n, int k){
+    // Precondition: 2 <= k <= BS_MAX_WIDTH
+    // Postcondition: return a table for the neighbourhoods of width k of the tours of n vertices,
+    //                or NULL if it would exceed BS_MAX_TABLE_BYTES or if there is not enough memory
+    if (bsTableBytes(n, k) > BS_MAX_TABLE_BYTES) return NULL;
+    bsTable* t = (bsTable*) calloc(1, sizeof(bsTable));
+    if (t == NULL) return NULL;
+    t->n = n;
+    t->k = k;
+    t->nbStates = (1 << (k-1)) * 2*k;
+    t->dp = (int32_t*) malloc((size_t)(k+1)*t->nbStates*sizeof(int32_t));
+    t->pred = (int8_t*) malloc((size_t)(n+1)*t->nbStates*sizeof(int8_t));
+    t->order = (int*) malloc(n*sizeof(int));
+    if (t->dp == NULL || t->pred == NULL || t->order == NULL){
+        bsFree(t);
+        return NULL;
+    }
+    return t;
+}
+
+void bsFree(bsTable* t){
+    if (t == NULL) return;
+    free(t->dp);
+    free(t->pred);
+    free(t->order);
+    free(t);
+}
+
+static inline int vertexAt(const int* sol, int n, int offset, int p){
+    // Postcondition: return the vertex of position p when the tour is read from offset
+    return sol[(offset + p) % n];
+}
+
+static inline void relax(int32_t* dp, int8_t* pred, size_t state, int value, int d){
+    if (value < dp[state]){
+        dp[state] = value;
+        pred[state] = d;
+    }
+}
+
+/**
+ * One step of the Balas-Simonetti local search
+ * Input: sol[0..n-1] contains a permutation of [0,n-1]; the vertex of position p is sol[(offset+p) % n]
+ * Output: sol is the best tour of the neighbourhood of width t->k of sol (with sol[offset] in place)
+ * Return the change of length of the tour (<= 0)
+ */
+int bsStep(bsTable* t, int* sol, int offset, const costProvider* cost){
+    int n = t->n, k = t->k, width = 2*k;
+    if (n < 3) return 0;
+    size_t layer = t->nbStates;
+    for (size_t c=0; c<(size_t)(k+1)*layer; c++) t->dp[c] = INT_MAX;
+    // start: vertex 0 is visited, the frontier is 1 and the last vertex is 0 = 1 + (k-1) - k
+    t->dp[(1 % (k+1))*layer + k-1] = 0;
+    t->pred[1*layer + k-1] = -1;
+    for (int f=1; f<n; f++){
+        int32_t* dp = t->dp + (f % (k+1))*layer;
+        int8_t* pred = t->pred + f*layer;
+        set ahead = createSet((f+k <= n) ? k : n-f); // elements e such that f+e < n
+        for (set S=0; setIndex(S) < ((size_t)1 << (k-1)); ++S){
+            if (S & ~ahead) continue;
+            // visiting f moves the frontier after the first vertex not in S
+            int run = 0;
+            while (run < k-1 && isIn(run+1, S)) run++;
+            int next = f + 1 + run;
+            set nextS = S >> (run + 1);
+            int32_t* nextDp = t->dp + (next % (k+1))*layer;
+            int8_t* nextPred = t->pred + next*layer;
+            for (int d=0; d<width; d++){
+                int v = dp[setIndex(S)*width + d];
+                if (v == INT_MAX) continue;
+                int last = vertexAt(sol, n, offset, f + d - k);
+                relax(nextDp, nextPred, setIndex(nextS)*width + k-1-run, v + costOf(cost, last, vertexAt(sol, n, offset, f)), d);
+                int e;
+                forEachElement(e, ahead & ~S) // visit f+e, the frontier stays
+                    relax(dp, pred, setIndex(addElement(S, e))*width + e + k, v + costOf(cost, last, vertexAt(sol, n, offset, f + e)), d);
+            }
+        }
+        for (size_t c=0; c<layer; c++) dp[c] = INT_MAX; // this layer becomes frontier f+k+1
+    }
+
+    // back to vertex 0 (all vertices are visited: the frontier is n and S is empty)
+    int32_t* dp = t->dp + (n % (k+1))*layer;
+    int best = INT_MAX, bestd = -1;
+    for (int d=0; d<width; d++){
+        if (dp[d] == INT_MAX) continue;
+        int length = dp[d] + costOf(cost, vertexAt(sol, n, offset, n + d - k), vertexAt(sol, n, offset, 0));
+        if (length < best){
+            best = length;
+            bestd = d;
+        }
+    }
+    int current = 0;
+    for (int p=0; p<n; p++) current += costOf(cost, vertexAt(sol, n, offset, p), vertexAt(sol, n, offset, (p+1) % n));
+    if (best >= current) return 0;
+
+    // rebuild the tour backwards, from the state of each vertex to the state before it was visited
+    int f = n, d = bestd;
+    set S = 0;
+    for (int p=n-1; p>=1; p--){
+        int last = f + d - k;
+        t->order[p] = vertexAt(sol, n, offset, last);
+        int prevd = t->pred[f*layer + setIndex(S)*width + d];
+        if (last < f){
+            // last was the frontier: the vertices from last+1 to f-1 had been visited, and those of S
+            S = createSet(f - last) | (S << (f - last));
+            f = last;
+        } else S = removeElement(S, last - f);
+        d = prevd;
+    }
+    t->order[0] = vertexAt(sol, n, offset, 0);
+    for (int p=0; p<n; p++) sol[(offset + p) % n] = t->order[p];
+    return best - current;
+}
+
+/**
+ * Balas-Simonetti local search
+ * Input: sol[0..n-1] contains a permutation of [0,n-1], and total = length of the tour associated with sol
+ * Output: sol[0..n-1] is a tour that is the best of its neighbourhood, read from position 0 and from position n/2
+ *         (so that the ends of the path explored by the DP are not always the same)
+ * Return the length of the tour associated with sol
+ */
+int balasSimonettiLS(bsTable* t, int* sol, int total, const costProvider* cost, bsStats* stats){
+    double start = wallTime();
+    bsStats local;
+    if (stats == NULL) stats = &local;
+    *stats = (bsStats){0};
+    int fruitless = 0; // number of consecutive steps that do not improve the tour
+    for (int offset=0; fruitless < 2; offset = (offset == 0) ? t->n/2 : 0){
+        int delta = bsStep(t, sol, offset, cost);
+        stats->steps++;
+        if (delta < 0){
+            total += delta;
+            stats->improvements++;
+            fruitless = 0;
+        } else fruitless++;
+    }
+    stats->seconds = wallTime() - start;
+    return total;
+}
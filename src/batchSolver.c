@@ -0,0 +1,310 @@
+/*
+ Batch solver: a stream of small instances solved with tables reused from one instance to the next
+
+ Each line of the input stream is an instance: its number of vertices n followed by the 2n
+ coordinates of its vertices (costs are TSPLIB EUC_2D distances). Each line of the output stream
+ answers the instance of the same line: the length of an optimal tour followed by its n vertices
+ starting from the depot (0), or -1 if the line is not a valid instance.
+ The process stays alive from one instance to the next, so that nothing is allocated per instance:
+ each thread owns an arena whose S-major table (heldKarp_table) grows to the largest instance it
+ has solved and is touched once when it grows, so that later instances pay no page fault, and
+ whose cost matrix is rewritten in place. Instances are read in batches of at most BATCH_SIZE:
+ a batch ends when it is full or when no complete line is available yet (so that a client waiting
+ for its answers is not kept waiting), the threads share its instances, and the answers are
+ written in the order of the input, with one write per batch.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "batchSolver.h"
+#include "timer.h"
+#include "instrument.h"
+
+#define MATRIX_STRIDE 32     // cells of a row of the cost matrix: BATCH_MAX_VERTICES rounded up to 64 bytes
+#define LINE_BYTES (1 << 16) // longest line of the input
+#define ANSWER_BYTES (12 + 3*BATCH_MAX_VERTICES) // longest line of the output
+
+batchServer* batchServerCreate(int nbThreads){
+    // Precondition: nbThreads >= 1
+    // Postcondition: return a server without tables yet, or NULL if there is not enough memory
+    batchServer* s = (batchServer*) calloc(1, sizeof(batchServer));
+    if (s == NULL) return NULL;
+    s->nbThreads = nbThreads;
+    s->arenas = (batchArena*) calloc(nbThreads, sizeof(batchArena));
+    s->instances = (batchInstance*) malloc(BATCH_SIZE*sizeof(batchInstance));
+    bool ok = s->arenas != NULL && s->instances != NULL;
+    for (int t=0; ok && t<nbThreads; t++){
+        batchArena* a = &s->arenas[t];
+        a->matrix = (int32_t*) aligned_alloc(64, MATRIX_STRIDE*MATRIX_STRIDE*sizeof(int32_t));
+        a->cost = (costProvider){.kind = COST_MATRIX32, .metric = METRIC_EUC_2D, .stride = MATRIX_STRIDE, .m32 = a->matrix};
+        ok = a->matrix != NULL;
+    }
+    if (!ok){
+        batchServerFree(s);
+        return NULL;
+    }
+    return s;
+}
+
+void batchServerFree(batchServer* s){
+    if (s == NULL) return;
+    for (int t=0; s->arenas != NULL && t<s->nbThreads; t++){
+        hkTableFree(s->arenas[t].table);
+        free(s->arenas[t].matrix);
+    }
+    free(s->arenas);
+    free(s->instances);
+    free(s);
+}
+
+size_t batchTableBytes(const batchServer* s){
+    // Postcondition: return the number of bytes of the tables of all threads
+    size_t bytes = 0;
+    for (int t=0; t<s->nbThreads; t++)
+        if (s->arenas[t].nmax > 0) bytes += 2*((size_t)s->arenas[t].nmax << (s->arenas[t].nmax-1))*sizeof(int);
+    return bytes;
+}
+
+uint64_t batchGrowths(const batchServer* s){
+    uint64_t growths = 0;
+    for (int t=0; t<s->nbThreads; t++) growths += s->arenas[t].growths;
+    return growths;
+}
+
+static bool growArena(batchArena* a, int n){
+    // Postcondition: the table of a holds n vertices and all its pages are mapped; return false if there is not enough memory
+    hkTableFree(a->table);
+    a->table = hkTableCreate(n, HK_LAYOUT_SMAJOR);
+    if (a->table == NULL){
+        a->nmax = 0;
+        return false;
+    }
+    memset(a->table->dp, 0, a->table->nbCells*sizeof(int));
+    memset(a->table->succ, 0, a->table->nbCells*sizeof(int));
+    a->nmax = n;
+    a->growths++;
+    return true;
+}
+
+static void solveInstance(batchArena* a, batchInstance* inst){
+    // Postcondition: inst->length and inst->tour are the length and the vertices of an optimal tour of inst
+    int n = inst->n;
+    inst->length = -1;
+    if (n < 1) return;
+    inst->tour[0] = 0;
+    if (n == 1){
+        inst->length = 0;
+        return;
+    }
+    if (n > a->nmax && !growArena(a, n)) return;
+    for (int i=0; i<n; i++)
+        for (int j=0; j<n; j++) a->matrix[i*MATRIX_STRIDE + j] = metricCost(METRIC_EUC_2D, inst->xy, i, j);
+    a->cost.n = n;
+    hkTable* t = a->table;
+    hkTableSetSize(t, n);
+    inst->length = heldKarp_table(n, &a->cost, t, NULL);
+    set S = createSet(n);
+    for (int p=1, i=0; p<n; p++){
+        i = t->succ[hkCell(t, S, i)];
+        inst->tour[p] = i;
+        S = removeElement(S, i);
+    }
+}
+
+typedef struct {
+    batchServer* server;
+    int count;          // number of instances of the batch
+    atomic_int next;    // next instance to solve
+} batchRound;
+
+typedef struct {
+    batchRound* round;
+    batchArena* arena;
+    bool spawned;       // false for the calling thread
+} batchWorker;
+
+static void* solveInstances(void* arg){
+    batchWorker* w = (batchWorker*) arg;
+    batchRound* r = w->round;
+    while (true){
+        int m = atomic_fetch_add_explicit(&r->next, 1, memory_order_relaxed);
+        if (m >= r->count) break;
+        solveInstance(w->arena, &r->server->instances[m]);
+    }
+    if (w->spawned) INSTR_MERGE();
+    return NULL;
+}
+
+typedef struct {
+    int fd;
+    char buffer[LINE_BYTES];
+    size_t pos, len;
+    bool eof;
+} streamReader;
+
+static bool refill(streamReader* r){
+    // Postcondition: the next bytes of the stream are in the buffer (the call blocks until there are some);
+    //                return false at the end of the stream
+    ssize_t got;
+    do got = read(r->fd, r->buffer, sizeof(r->buffer)); while (got < 0 && errno == EINTR);
+    if (got <= 0){
+        r->eof = true;
+        return false;
+    }
+    r->pos = 0;
+    r->len = got;
+    return true;
+}
+
+static int readLine(streamReader* r, char* line, bool wait){
+    // Postcondition: line is the next non-empty line of the stream and return 1 (line is empty, so that the instance
+    //                is invalid, if the line is longer than LINE_BYTES-1 characters: it is consumed up to its end),
+    //                or return 0 at the end of the stream, or -1 if no byte is available yet and wait is false
+    size_t len = 0;
+    bool tooLong = false;
+    while (true){
+        if (r->pos == r->len){
+            if (r->eof) break;
+            if (len == 0 && !wait){
+                struct pollfd p = {.fd = r->fd, .events = POLLIN};
+                if (poll(&p, 1, 0) == 0) return -1;
+            }
+            if (!refill(r)) break;
+        }
+        char c = r->buffer[r->pos++];
+        if (c == '\n'){
+            if (len > 0) break;
+            continue; // empty line
+        }
+        if (len < LINE_BYTES-1) line[len++] = c;
+        else tooLong = true;
+    }
+    line[tooLong ? 0 : len] = 0;
+    return len > 0 ? 1 : 0;
+}
+
+static void parseInstance(const char* line, batchInstance* inst){
+    // Postcondition: inst is the instance of line, with inst->n = -1 if line is not a valid instance
+    // The coordinates must be finite, and the tour lengths must fit in an int: n times the diagonal of the
+    // bounding box bounds them (the lines come from a socket, so nothing else guarantees it).
+    char* end;
+    long n = strtol(line, &end, 10);
+    inst->n = -1;
+    if (end == line || n < 1 || n > BATCH_MAX_VERTICES) return;
+    double minX = INFINITY, maxX = -INFINITY, minY = INFINITY, maxY = -INFINITY;
+    for (int k=0; k<2*n; k++){
+        const char* p = end;
+        double v = strtod(p, &end);
+        if (end == p || !isfinite(v)) return;
+        inst->xy[k] = v;
+        if (k % 2 == 0){
+            minX = fmin(minX, v);
+            maxX = fmax(maxX, v);
+        } else {
+            minY = fmin(minY, v);
+            maxY = fmax(maxY, v);
+        }
+    }
+    if (n*(hypot(maxX - minX, maxY - minY) + 1) >= INT_MAX) return;
+    while (*end == ' ' || *end == '\t' || *end == '\r') end++;
+    if (*end == 0) inst->n = (int)n;
+}
+
+static bool writeAll(int fd, const char* p, size_t bytes){
+    // Postcondition: return true if the bytes are written to fd (without SIGPIPE when fd is a socket)
+    while (bytes > 0){
+        ssize_t done = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (done < 0 && errno == ENOTSOCK) done = write(fd, p, bytes);
+        if (done < 0){
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += done;
+        bytes -= done;
+    }
+    return true;
+}
+
+/**
+ * Answer the instances read from in, writing the answers to out, until the end of in
+ * Output: s->stats is updated
+ * Return 0, or -1 if there is not enough memory or the answers cannot be written
+ */
+int batchServe(batchServer* s, int in, int out){
+    streamReader* reader = (streamReader*) malloc(sizeof(streamReader));
+    char* line = (char*) malloc(LINE_BYTES);
+    char* answers = (char*) malloc(BATCH_SIZE*ANSWER_BYTES);
+    batchWorker* workers = (batchWorker*) malloc(s->nbThreads*sizeof(batchWorker));
+    int result = -1;
+    if (reader == NULL || line == NULL || answers == NULL || workers == NULL) goto done;
+    *reader = (streamReader){.fd = in};
+    batchRound round = {.server = s};
+    double start = wallTime();
+    while (true){
+        // read until the batch is full, or no line is waiting once the batch has an instance
+        int count = 0;
+        while (count < BATCH_SIZE && readLine(reader, line, count == 0) == 1)
+            parseInstance(line, &s->instances[count++]);
+        if (count == 0) break;
+
+        round.count = count;
+        atomic_store_explicit(&round.next, 0, memory_order_relaxed);
+        int nbThreads = (s->nbThreads < count) ? s->nbThreads : count;
+        int launched = 1;
+        for (int t=0; t<nbThreads; t++) workers[t] = (batchWorker){.round = &round, .arena = &s->arenas[t], .spawned = t > 0};
+        while (launched < nbThreads && pthread_create(&s->arenas[launched].thread, NULL, solveInstances, &workers[launched]) == 0) launched++;
+        solveInstances(&workers[0]); // the calling thread is worker 0
+        for (int t=1; t<launched; t++) pthread_join(s->arenas[t].thread, NULL);
+
+        size_t bytes = 0;
+        for (int m=0; m<count; m++){
+            batchInstance* inst = &s->instances[m];
+            if (inst->n > s->stats.nmax) s->stats.nmax = inst->n;
+            if (inst->length < 0){
+                s->stats.invalid++;
+                bytes += sprintf(answers + bytes, "-1\n");
+                continue;
+            }
+            bytes += sprintf(answers + bytes, "%d", inst->length);
+            for (int p=0; p<inst->n; p++) bytes += sprintf(answers + bytes, " %d", inst->tour[p]);
+            answers[bytes++] = '\n';
+        }
+        s->stats.instances += count;
+        s->stats.batches++;
+        if (!writeAll(out, answers, bytes)) goto done;
+    }
+    s->stats.seconds += wallTime() - start;
+    result = 0;
+done:
+    free(reader);
+    free(line);
+    free(answers);
+    free(workers);
+    return result;
+}
+
+int batchListen(const char* path){
+    // Postcondition: return a Unix-domain socket listening on path (replacing an older one), or -1
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,324 @@
+/*
+ Benchmark harness of the DP solvers and of the local searches
+
+ For each algorithm, each number of vertices and each seed, the run is repeated and every
+ repetition is done in a child process: its peak resident memory is then its own (getrusage on the
+ whole process would only ever grow), and its CPU time is given by wait4. The child measures the
+ wall-clock time of the solver only (not the creation of the instance) with the monotonic clock,
+ and sends it back through a pipe with the result and the amount of work done.
+ The median, minimum and maximum wall times of the repetitions are reported, with their relative
+ standard deviation, in CSV or JSON.
+
+ Usage: bench [-a algorithms] [-d nmin:nmax[:step]] [-l nmin:nmax[:step]] [-s seeds] [-r repeats] [-o file]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "heldKarp.h"
+#include "localSearch.h"
+#include "neighbourLS.h"
+#include "memoTable.h"
+#include "timer.h"
+#include "rng.h"
+
+#define NAIVE_MAX_VERTICES 12 // computeD explores (n-1)! paths
+#define MAX_REPEATS 100
+
+typedef enum {
+    BENCH_COMPUTED,      // naive recursion
+    BENCH_MEMO,          // computeD_memo
+    BENCH_ITER,          // heldKarp_iter
+    BENCH_GREEDYLS,      // greedyLS from a random tour
+    BENCH_GREEDYLS2,     // greedyLS2 from the same random tour
+    BENCH_LS_ARRAY,      // neighbourLS (2-opt and Or-opt, 10 candidates) from the same random tour, on a permutation array
+    BENCH_LS_LIST,       // the same search on a two-level doubly-linked list
+    BENCH_NB_ALGOS
+} benchAlgo;
+
+static const char* algoNames[] = {"computeD", "computeD_memo", "heldKarp_iter", "greedyLS", "greedyLS2", "neighbourLS-array", "neighbourLS-list"};
+static const char* workNames[] = {"calls", "calls", "states", "moves", "moves", "moves", "moves"};
+
+typedef struct {
+    int length;          // length of the tour found
+    double wall;         // seconds, measured by the child around the solver
+    uint64_t work;       // calls, states or moves evaluated
+} runResult;
+
+typedef struct {
+    runResult result;
+    double cpu;          // user + system seconds of the child
+    long peakKB;         // peak resident memory of the child
+    bool ok;
+} runMeasure;
+
+static bool isLocalSearch(benchAlgo a){
+    return a == BENCH_GREEDYLS || a == BENCH_GREEDYLS2 || a == BENCH_LS_ARRAY || a == BENCH_LS_LIST;
+}
+
+static costProvider* benchInstance(int n, uint64_t seed, costKind kind){
+    // Postcondition: return the costs of n random points of [0,1000)^2 drawn from seed
+    double* xy = (double*) malloc(2*(size_t)n*sizeof(double));
+    if (xy == NULL) return NULL;
+    rng r;
+    rngInit(&r, seed, 0);
+    for (int i=0; i<2*n; i++) xy[i] = rngNext(&r, 1000);
+    costProvider* cost = costFromPoints(n, xy, METRIC_TRUNC_2D, kind);
+    free(xy);
+    return cost;
+}
+
+static bool solve(benchAlgo a, int n, uint64_t seed, runResult* res){
+    // Postcondition: res holds the result of the run of a on the instance (n, seed); false if memory is lacking
+    // the candidate-list searches go up to instances whose matrix would not fit in memory
+    bool candidates = (a == BENCH_LS_ARRAY || a == BENCH_LS_LIST);
+    costProvider* cost = benchInstance(n, seed, candidates ? COST_COORDS : COST_MATRIX16);
+    if (cost == NULL) return false;
+    bool ok = true;
+    if (isLocalSearch(a)){
+        int* sol = (int*) malloc(n*sizeof(int));
+        if (sol == NULL) ok = false;
+        else {
+            rng r;
+            rngInit(&r, seed, 1);
+            int total = randomTour(n, cost, &r, sol);
+            candidateLists* cand = candidates ? candidatesCreate(n, cost, 10) : NULL;
+            if (total < 0 || (candidates && cand == NULL)) ok = false;
+            else if (candidates){
+                lsStats stats;
+                lsTourChoice = (a == BENCH_LS_LIST) ? LS_TOUR_LIST : LS_TOUR_ARRAY;
+                double t = wallTime();
+                res->length = neighbourLS(n, sol, total, cost, cand, LS_MOVE_BIT(LS_2OPT) | LS_MOVE_BIT(LS_OROPT), &stats);
+                res->wall = wallTime() - t;
+                res->work = stats.evaluated[LS_2OPT] + stats.evaluated[LS_OROPT];
+                ok = res->length >= 0;
+            } else {
+                uint64_t evaluated = 0;
+                double t = wallTime();
+                res->length = (a == BENCH_GREEDYLS) ? greedyLS(n, sol, total, cost, &evaluated) : greedyLS2(n, sol, total, cost, &evaluated);
+                res->wall = wallTime() - t;
+                res->work = evaluated;
+            }
+            candidatesFree(cand);
+        }
+        free(sol);
+    } else if (a == BENCH_ITER){
+        int** dp = allocRows(n);
+        int** succ = allocRows(n);
+        if (dp == NULL || succ == NULL) ok = false;
+        else {
+            nb_states = 0;
+            double t = wallTime();
+            res->length = heldKarp_iter(n, cost, dp, succ);
+            res->wall = wallTime() - t;
+            res->work = nb_states;
+        }
+        freeRows(n, dp);
+        freeRows(n, succ);
+    } else {
+        memoTable* memo = (a == BENCH_MEMO) ? memoCreate(n <= DENSE_MAX_VERTICES ? MEMO_DENSE : MEMO_SPARSE, n) : NULL;
+        if (a == BENCH_MEMO && memo == NULL) ok = false;
+        else {
+            nb_calls = 0;
+            double t = wallTime();
+            res->length = (a == BENCH_MEMO) ? computeD_memo(0, createSet(n), n, cost, memo) : computeD(0, createSet(n), n, cost);
+            res->wall = wallTime() - t;
+            res->work = nb_calls;
+        }
+        memoFree(memo);
+    }
+    costFree(cost);
+    return ok;
+}
+
+static runMeasure measure(benchAlgo a, int n, uint64_t seed){
+    // Postcondition: return the measures of one run of a on (n, seed), done in a child process
+    runMeasure m = {.ok = false};
+    int fds[2];
+    if (pipe(fds) != 0) return m;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0){
+        close(fds[0]);
+        close(fds[1]);
+        return m;
+    }
+    if (pid == 0){
+        close(fds[0]);
+        runResult res;
+        bool ok = solve(a, n, seed, &res);
+        if (ok && write(fds[1], &res, sizeof(res)) != sizeof(res)) ok = false;
+        close(fds[1]);
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    bool received = (read(fds[0], &m.result, sizeof(m.result)) == sizeof(m.result));
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid) return m;
+    m.cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec*1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec*1e-6;
+    m.peakKB = usage.ru_maxrss;
+    m.ok = received && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return m;
+}
+
+static int compareDoubles(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double* v, int k){
+    // Postcondition: v[0..k-1] is sorted and its median is returned
+    qsort(v, k, sizeof(double), compareDoubles);
+    return (k % 2 == 1) ? v[k/2] : (v[k/2-1] + v[k/2]) / 2;
+}
+
+static bool parseRange(const char* s, int* nmin, int* nmax, int* step){
+    *step = 1;
+    int k = sscanf(s, "%d:%d:%d", nmin, nmax, step);
+    if (k == 1) *nmax = *nmin;
+    return k >= 1 && *nmin >= 2 && *nmin <= *nmax && *step >= 1;
+}
+
+int main(int argc, char** argv){
+    // Options: -a algorithms: comma-separated names among computeD, computeD_memo, heldKarp_iter, greedyLS, greedyLS2,
+    //             neighbourLS-array, neighbourLS-list (all by default)
+    //          -d nmin:nmax[:step]: numbers of vertices of the DP solvers (10:18:2 by default; computeD stops at NAIVE_MAX_VERTICES)
+    //          -l nmin:nmax[:step]: numbers of vertices of the local searches (100:400:100 by default)
+    //          -s seeds: number of instances per number of vertices, drawn from the seeds 1..seeds (3 by default)
+    //          -r repeats: number of repetitions of each run (5 by default)
+    //          -o file: results in file, as JSON if it ends with .json, as CSV otherwise (bin/bench.csv by default)
+    bool chosen[BENCH_NB_ALGOS];
+    for (int a=0; a<BENCH_NB_ALGOS; a++) chosen[a] = true;
+    int dpMin = 10, dpMax = 18, dpStep = 2;
+    int lsMin = 100, lsMax = 400, lsStep = 100;
+    int nbSeeds = 3, repeats = 5;
+    const char* path = "bin/bench.csv";
+    int opt;
+    while ((opt = getopt(argc, argv, "a:d:l:s:r:o:")) != -1){
+        switch (opt){
+            case 'a': {
+                for (int a=0; a<BENCH_NB_ALGOS; a++) chosen[a] = false;
+                char* list = strdup(optarg);
+                for (char* name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")){
+                    int a = 0;
+                    while (a < BENCH_NB_ALGOS && strcmp(name, algoNames[a]) != 0) a++;
+                    if (a == BENCH_NB_ALGOS){
+                        printf("Unknown algorithm %s.\n", name);
+                        return 0;
+                    }
+                    chosen[a] = true;
+                }
+                free(list);
+                break;
+            }
+            case 'd':
+                if (!parseRange(optarg, &dpMin, &dpMax, &dpStep) || dpMax > DENSE_MAX_VERTICES){
+                    printf("The DP range must be nmin:nmax[:step] with 2 <= nmin <= nmax <= %d.\n", DENSE_MAX_VERTICES);
+                    return 0;
+                }
+                break;
+            case 'l':
+                if (!parseRange(optarg, &lsMin, &lsMax, &lsStep)){
+                    printf("The local search range must be nmin:nmax[:step] with 2 <= nmin <= nmax.\n");
+                    return 0;
+                }
+                break;
+            case 's':
+                nbSeeds = atoi(optarg);
+                if (nbSeeds < 1){
+                    printf("The number of seeds must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'r':
+                repeats = atoi(optarg);
+                if (repeats < 1 || repeats > MAX_REPEATS){
+                    printf("The number of repetitions must be in [1,%d].\n", MAX_REPEATS);
+                    return 0;
+                }
+                break;
+            case 'o':
+                path = optarg;
+                break;
+            default:
+                printf("Usage: %s [-a algorithms] [-d nmin:nmax[:step]] [-l nmin:nmax[:step]] [-s seeds] [-r repeats] [-o file]\n", argv[0]);
+                return 0;
+        }
+    }
+    size_t len = strlen(path);
+    bool json = (len >= 5 && strcmp(path + len - 5, ".json") == 0);
+    FILE* out = fopen(path, "w");
+    if (out == NULL){
+        printf("Cannot create %s.\n", path);
+        return 0;
+    }
+    if (json) fprintf(out, "[");
+    else fprintf(out, "algorithm,n,seed,repeats,length,wall_median_s,wall_min_s,wall_max_s,wall_rsd_pct,cpu_median_s,peak_rss_kb,work,work_unit,work_per_s\n");
+
+    printf("%-17s %6s %4s %8s %12s %8s %12s %10s %14s\n",
+           "algorithm", "n", "seed", "length", "wall (s)", "rsd", "cpu (s)", "peak (MB)", "work/s");
+    bool first = true;
+    for (int a=0; a<BENCH_NB_ALGOS; a++){
+        if (!chosen[a]) continue;
+        int nmin = isLocalSearch(a) ? lsMin : dpMin;
+        int nmax = isLocalSearch(a) ? lsMax : dpMax;
+        int step = isLocalSearch(a) ? lsStep : dpStep;
+        if (a == BENCH_COMPUTED && nmax > NAIVE_MAX_VERTICES) nmax = NAIVE_MAX_VERTICES;
+        for (int n=nmin; n<=nmax; n+=step){
+            for (uint64_t seed=1; seed<=(uint64_t)nbSeeds; seed++){
+                double wall[MAX_REPEATS], cpu[MAX_REPEATS];
+                long peakKB = 0;
+                runResult res = {0};
+                int done = 0;
+                for (int k=0; k<repeats; k++){
+                    runMeasure m = measure(a, n, seed);
+                    if (!m.ok) break;
+                    res = m.result;
+                    wall[done] = m.result.wall;
+                    cpu[done] = m.cpu;
+                    if (m.peakKB > peakKB) peakKB = m.peakKB;
+                    done++;
+                }
+                if (done < repeats){
+                    printf("%-17s %6d %4lu failed (not enough memory?)\n", algoNames[a], n, (unsigned long)seed);
+                    continue;
+                }
+                double mean = 0, var = 0;
+                for (int k=0; k<done; k++) mean += wall[k];
+                mean /= done;
+                for (int k=0; k<done; k++) var += (wall[k] - mean)*(wall[k] - mean);
+                double rsd = (done > 1 && mean > 0) ? 100*sqrt(var/(done-1))/mean : 0;
+                double wallMedian = median(wall, done);
+                double cpuMedian = median(cpu, done);
+                double rate = wallMedian > 0 ? res.work/wallMedian : 0;
+                printf("%-17s %6d %4lu %8d %12.6f %7.1f%% %12.6f %10.1f %14.4g\n", algoNames[a], n, (unsigned long)seed,
+                       res.length, wallMedian, rsd, cpuMedian, peakKB/1e3, rate);
+                if (json){
+                    fprintf(out, "%s\n  {\"algorithm\": \"%s\", \"n\": %d, \"seed\": %lu, \"repeats\": %d, \"length\": %d, "
+                            "\"wall_median_s\": %.9f, \"wall_min_s\": %.9f, \"wall_max_s\": %.9f, \"wall_rsd_pct\": %.3f, "
+                            "\"cpu_median_s\": %.6f, \"peak_rss_kb\": %ld, \"work\": %lu, \"work_unit\": \"%s\", \"work_per_s\": %.6g}",
+                            first ? "" : ",", algoNames[a], n, (unsigned long)seed, done, res.length,
+                            wallMedian, wall[0], wall[done-1], rsd, cpuMedian, peakKB, (unsigned long)res.work, workNames[a], rate);
+                } else {
+                    fprintf(out, "%s,%d,%lu,%d,%d,%.9f,%.9f,%.9f,%.3f,%.6f,%ld,%lu,%s,%.6g\n",
+                            algoNames[a], n, (unsigned long)seed, done, res.length, wallMedian, wall[0], wall[done-1], rsd,
+                            cpuMedian, peakKB, (unsigned long)res.work, workNames[a], rate);
+                }
+                first = false;
+            }
+        }
+    }
+    if (json) fprintf(out, "\n]\n");
+    fclose(out);
+    printf("Results written in %s\n", path);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ Cost of the arcs of an instance, stored as a matrix or computed from the coordinates of the vertices
+
+ The matrix is a single block aligned on a cache line, whose rows are padded to a multiple of 64
+ bytes, so that a row starts on a cache line and costOf needs no indirection. Its cells are 16-bit
+ wide when the largest cost fits, which halves the memory traffic of the solvers.
+ Without a matrix, only the coordinates are kept (16 bytes per vertex, x and y side by side) and
+ each cost is recomputed on demand: this is what makes instances of 10^5 vertices fit in memory.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "costProvider.h"
+
+#define LINE 64 // bytes
+
+static size_t paddedRow(int n, size_t cellBytes){
+    size_t perLine = LINE / cellBytes;
+    return (n + perLine - 1) / perLine * perLine;
+}
+
+static bool allocMatrix(costProvider* c, int max, costKind kind){
+    // Postcondition: the matrix of c is allocated, with 16-bit cells if kind = COST_MATRIX16 and max fits,
+    //                or false is returned if there is not enough memory
+    c->maxCost = max;
+    c->kind = (max <= UINT16_MAX && kind == COST_MATRIX16) ? COST_MATRIX16 : COST_MATRIX32;
+    size_t cellBytes = (c->kind == COST_MATRIX16) ? sizeof(uint16_t) : sizeof(int32_t);
+    c->stride = paddedRow(c->n, cellBytes);
+    size_t bytes = (size_t)c->n*c->stride*cellBytes;
+    void* cells = aligned_alloc(LINE, bytes > 0 ? bytes : LINE);
+    if (cells == NULL) return false;
+    if (c->kind == COST_MATRIX16) c->m16 = (uint16_t*) cells;
+    else c->m32 = (int32_t*) cells;
+    return true;
+}
+
+/**
+ * Costs of the n vertices whose coordinates are xy[0..2n-1]
+ * kind = COST_MATRIX16 asks for a matrix, which is widened to 32 bits if a cost does not fit on 16;
+ * kind = COST_COORDS keeps a copy of the coordinates only.
+ * Return NULL if there is not enough memory
+ */
+costProvider* costFromPoints(int n, const double* xy, costMetric metric, costKind kind){
+    costProvider* c = (costProvider*) calloc(1, sizeof(costProvider));
+    if (c == NULL) return NULL;
+    c->n = n;
+    c->metric = metric;
+    c->xy = (double*) malloc(2*(size_t)(n > 0 ? n : 1)*sizeof(double));
+    if (c->xy == NULL){
+        free(c);
+        return NULL;
+    }
+    memcpy(c->xy, xy, 2*(size_t)n*sizeof(double));
+
+    if (kind == COST_COORDS){
+        c->kind = COST_COORDS;
+        // the largest cost is at most the one of the diagonal of the bounding box (plus rounding)
+        double minX = 0, maxX = 0, minY = 0, maxY = 0;
+        for (int i=0; i<n; i++){
+            if (i == 0 || xy[2*i] < minX) minX = xy[2*i];
+            if (i == 0 || xy[2*i] > maxX) maxX = xy[2*i];
+            if (i == 0 || xy[2*i+1] < minY) minY = xy[2*i+1];
+            if (i == 0 || xy[2*i+1] > maxY) maxY = xy[2*i+1];
+        }
+        double corners[4] = {minX, minY, maxX, maxY};
+        c->maxCost = (metric == METRIC_GEO) ? (int)(EARTH_RADIUS*acos(-1.0)) + 1 : metricCost(metric, corners, 0, 1) + 1;
+        return c;
+    }
+
+    int max = 0;
+    for (int i=0; i<n; i++)
+        for (int j=i+1; j<n; j++){
+            int d = metricCost(metric, xy, i, j);
+            if (d > max) max = d;
+        }
+    if (!allocMatrix(c, max, kind)){
+        free(c->xy);
+        free(c);
+        return NULL;
+    }
+    for (int i=0; i<n; i++){
+        for (int j=0; j<n; j++){
+            int d = (i == j) ? 0 : metricCost(metric, xy, i, j);
+            if (c->kind == COST_MATRIX16) c->m16[(size_t)i*c->stride + j] = (uint16_t)d;
+            else c->m32[(size_t)i*c->stride + j] = d;
+        }
+    }
+    return c;
+}
+
+/**
+ * Costs given explicitly: the cost of (i,j) is weights[i*n+j], and the diagonal is ignored
+ * Precondition: the weights are non negative
+ * The costs are stored in a matrix whatever kind is, as there are no coordinates to compute them from.
+ * Return NULL if there is not enough memory
+ */
+costProvider* costFromWeights(int n, const int32_t* weights, costKind kind){
+    costProvider* c = (costProvider*) calloc(1, sizeof(costProvider));
+    if (c == NULL) return NULL;
+    c->n = n;
+    c->metric = METRIC_TRUNC_2D; // unused
+    int max = 0;
+    for (size_t i=0; i<(size_t)n; i++)
+        for (size_t j=0; j<(size_t)n; j++)
+            if (i != j && weights[i*n + j] > max) max = weights[i*n + j];
+    if (!allocMatrix(c, max, kind == COST_COORDS ? COST_MATRIX16 : kind)){
+        free(c);
+        return NULL;
+    }
+    for (size_t i=0; i<(size_t)n; i++){
+        for (size_t j=0; j<(size_t)n; j++){
+            int d = (i == j) ? 0 : weights[i*n + j];
+            if (c->kind == COST_MATRIX16) c->m16[i*c->stride + j] = (uint16_t)d;
+            else c->m32[i*c->stride + j] = d;
+        }
+    }
+    return c;
+}
+
+void costFree(costProvider* c){
+    if (c == NULL) return;
+    free(c->m16);
+    free(c->m32);
+    free(c->xy);
+    free(c);
+}
+
+size_t costBytes(const costProvider* c){
+    // Postcondition: return the memory used by the costs
+    size_t bytes = (c->xy == NULL) ? 0 : 2*(size_t)c->n*sizeof(double);
+    if (c->kind == COST_MATRIX16) bytes += (size_t)c->n*c->stride*sizeof(uint16_t);
+    if (c->kind == COST_MATRIX32) bytes += (size_t)c->n*c->stride*sizeof(int32_t);
+    return bytes;
+}
+
+const char* costKindName(costKind kind){
+    static const char* names[] = {"16-bit matrix", "32-bit matrix", "coordinates"};
+    return names[kind];
+}
@@ -0,0 +1,174 @@
+/*
+ Held-Karp dynamic programming: recursive, memoised and bottom-up versions
+ Copyright (C) 2023 Christine Solnon
+ Ce programme est un logiciel libre ; vous pouvez le redistribuer et/ou le modifier au titre des clauses de la Licence Publique Générale GNU, telle que publiée par la Free Software Foundation. Ce programme est distribué dans l'espoir qu'il sera utile, mais SANS AUCUNE GARANTIE ; sans même une garantie implicite de COMMERCIABILITE ou DE CONFORMITE A UNE UTILISATION PARTICULIERE. Voir la Licence Publique Générale GNU pour plus de détails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include "heldKarp.h"
+#include "instrument.h"
+
+__uint64_t nb_calls = 0; // number of calls to computeD
+__uint64_t nb_states = 0;          // nb of states in the memoisation table
+
+/**
+ * Held-Karp algorithm for the Travelling Salesman Problem
+ */
+int computeD(int i, set s, int n, const costProvider* cost){
+    nb_calls += 1;
+    // Preconditions: isIn(i,s) = false and isIn(0,s) = false
+    // Postrelation: return the cost of the smallest path that starts from i, visits each vertex of s exactly once, and ends on 0
+    if (isEmpty(s)) return costOf(cost, i, 0);
+    int min = INT_MAX;
+    int j;
+    forEachElement(j, s){
+        int d = computeD(j, removeElement(s,j), n, cost);
+        if (costOf(cost, i, j) + d < min) min = costOf(cost, i, j) + d;
+    }
+    return min;
+}
+
+/**
+ * computeD version with memoisation
+ */
+int computeD_memo(int i, set s, int n, const costProvider* cost, memoTable* memo){
+    nb_calls += 1;
+    // Preconditions: isIn(i,s) = false and isIn(0,s) = false
+    // Postrelation: return the cost of the smallest path that starts from i, visits each vertex of s exactly once, and ends on 0
+    if (isEmpty(s)) return costOf(cost, i, 0);
+    int known;
+    if (memoGet(memo, i, s, &known)) return known;
+    int min = INT_MAX;
+    int j;
+    forEachElement(j, s){
+        int d = computeD_memo(j, removeElement(s,j), n, cost, memo);
+        if (costOf(cost, i, j) + d < min) min = costOf(cost, i, j) + d;
+    }
+    memoPut(memo, i, s, min);
+    return min;
+}
+
+int heldKarp_iter(int n, const costProvider* cost, int **dp, int **succ){
+    size_t FULL = (size_t)1 << (n-1); // stop when 2^(n-1) - 1 states are reached
+    set ALL = createSet(n); // full set {1,2,...,n-1}
+    INSTR_START(tInit);
+    // no fill loop: subsets are computed in increasing order, so every cell dp[j][S\{j}] read below is written first,
+    // with the length of a path (the graph is complete): no cell read can be INT_MAX
+    // base case: start from depot (0) and go to the first vertex
+    for(int i=1; i<n; ++i) dp[i][0] = costOf(cost, i, 0);
+    INSTR_PHASE(PHASE_INIT, tInit);
+
+    // compute the cost of all paths
+    INSTR_START(tSweep);
+    INSTR_PERF_BEGIN();
+    for(set S=1; setIndex(S)<FULL; ++S){ // all subsets of vertices
+        int i, j;
+        forEachElement(i, ALL & ~S){ // i must not be in S
+            int best = INT_MAX;
+            int bestj = -1;
+            forEachElement(j, S){ // j must be in S
+                set S2 = removeElement(S,j);
+                int alt = costOf(cost, i, j) + dp[j][setIndex(S2)];
+                if(alt < best){
+                    best  = alt;
+                    bestj = j;
+                }
+            }
+            dp[i][setIndex(S)] = best;
+            succ[i][setIndex(S)] = bestj;
+            nb_states++;
+            INSTR_COUNT(COUNTER_STATES, 1);
+        }
+    }
+    INSTR_PERF_END();
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+
+    // return to depot (0)
+    int best = INT_MAX;
+    int bestj = -1; 
+    for(int j=1; j<n; ++j){
+        int alt = costOf(cost, 0, j) + dp[j][setIndex(removeElement(ALL,j))];
+        if(alt < best){
+            best  = alt;
+            bestj = j;
+        }
+    }
+    succ[0][setIndex(ALL)] = bestj;
+    return best;
+}
+
+/**
+ * Print the tour, iterate over the successors
+ * starting from the depot (0) and going to the first vertex
+ * and then to the next vertex, etc.
+ * The tour ends when we return to the depot (0)
+ */
+void printTour(int n, int **succ){
+    INSTR_START(t);
+    set S = createSet(n);   // full set {1,2,...,n-1}
+    int i = 0;
+    printf("Circuit : 0");
+    for(int k=0; k<n-1; ++k){
+        int j = succ[i][setIndex(S)];
+        if(j==-1){ printf(" ?"); break; }
+        printf(" %d", j);
+        S = removeElement(S, j);
+        i = j;
+    }
+    printf(" 0\n");
+    INSTR_PHASE(PHASE_RECONSTRUCT, t);
+}
+
+typedef struct {
+    arena* storage;     // blocks of the rows
+    int* rows[];
+} rowTable;
+
+static rowTable* rowTableOf(int** rows){
+    // Precondition: rows was returned by allocRowsPages
+    return (rowTable*)((char*)rows - offsetof(rowTable, rows));
+}
+
+int** allocRowsPages(int n, arenaPages pages){
+    // Postcondition: return n rows of 2^(n-1) integers taken from an arena of the given pages
+    //                (zero-filled on first access), or NULL if there is not enough memory
+    INSTR_START(t);
+    rowTable* r = (rowTable*) malloc(sizeof(rowTable) + n*sizeof(int*));
+    if (r == NULL) return NULL;
+    size_t rowBytes = ((size_t)1 << (n-1))*sizeof(int);
+    // a single block for all rows (plus its header), so that only its first page is touched here
+    r->storage = arenaCreatePages(n*(rowBytes + 64) + 4096, pages);
+    bool ok = (r->storage != NULL);
+    for (int i=0; ok && i<n; i++){
+        r->rows[i] = (int*) arenaAlloc(r->storage, rowBytes);
+        ok = (r->rows[i] != NULL);
+    }
+    if (!ok){
+        arenaFree(r->storage);
+        free(r);
+        return NULL;
+    }
+    INSTR_PHASE(PHASE_ALLOC, t);
+    return r->rows;
+}
+
+int** allocRows(int n){
+    // Postcondition: return n rows of 2^(n-1) integers on transparent huge pages, or NULL if there is not enough memory
+    return allocRowsPages(n, ARENA_PAGES_TRANSPARENT);
+}
+
+arena* rowsArena(int** rows){
+    // Postcondition: return the arena of rows, returned by allocRows or allocRowsPages
+    return rowTableOf(rows)->storage;
+}
+
+void freeRows(int n, int** rows){
+    (void)n;
+    if (rows == NULL) return;
+    rowTable* r = rowTableOf(rows);
+    arenaFree(r->storage);
+    free(r);
+}
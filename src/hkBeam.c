@@ -0,0 +1,266 @@
+/*
+ Bounded-width (beam) Held-Karp: heuristic tours at any number of vertices
+
+ The states (i,S) of the forward recurrence (path from the depot 0 visiting S and ending on i) are
+ built layer by layer, by increasing size of S, as in heldKarp_table. Instead of all the states of a
+ layer, only the B best ones are kept: the candidates generated from the B states of the previous
+ layer go into a max-heap of at most B elements, a candidate better than the worst one replaces it,
+ and a hash table on (i,S) merges the candidates that reach the same state, keeping the best value.
+ Sets are bit vectors of n bits, so n is not limited by the width of the set type; their hash is the
+ XOR of a random key per vertex, updated in O(1) when a vertex is added, and the end vertex i is
+ mixed into it to choose the cell of (i,S).
+ Each state records its parent in the previous layer and its vertex, and the tour is rebuilt from
+ the best state of the last layer. Memory is O(n B) and time O(n^2 B log B). With a width at least
+ equal to the largest layer, the result is the optimum of heldKarp_iter; narrower beams trade quality
+ for time and memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "hkBeam.h"
+#include "rng.h"
+
+hkBeam* hkBeamCreate(int n, int width){
+    // Precondition: n >= 2, width >= 1
+    // Postcondition: return the tables of a beam of the given width for n vertices, or NULL if there is not enough memory
+    hkBeam* b = (hkBeam*) calloc(1, sizeof(hkBeam));
+    if (b == NULL) return NULL;
+    b->n = n;
+    b->width = width;
+    b->words = (n + 63) / 64;
+    size_t cells = 2;
+    while (cells < 2*(size_t)width) cells *= 2;
+    b->tableMask = cells - 1;
+    bool ok = true;
+    for (int l=0; l<2; l++){
+        b->sets[l] = (uint64_t*) malloc((size_t)width*b->words*sizeof(uint64_t));
+        b->hashes[l] = (uint64_t*) malloc(width*sizeof(uint64_t));
+        b->values[l] = (int32_t*) malloc(width*sizeof(int32_t));
+        b->vertices[l] = (int32_t*) malloc(width*sizeof(int32_t));
+        ok = ok && b->sets[l] != NULL && b->hashes[l] != NULL && b->values[l] != NULL && b->vertices[l] != NULL;
+    }
+    b->parents = (beamParent*) malloc((size_t)n*width*sizeof(beamParent));
+    b->candValue = (int32_t*) malloc(width*sizeof(int32_t));
+    b->candParent = (int32_t*) malloc(width*sizeof(int32_t));
+    b->candVertex = (int32_t*) malloc(width*sizeof(int32_t));
+    b->candHash = (uint64_t*) malloc(width*sizeof(uint64_t));
+    b->heap = (int32_t*) malloc(width*sizeof(int32_t));
+    b->heapPos = (int32_t*) malloc(width*sizeof(int32_t));
+    b->table = (int32_t*) malloc(cells*sizeof(int32_t));
+    b->zobrist = (uint64_t*) malloc(n*sizeof(uint64_t));
+    if (!ok || b->parents == NULL || b->candValue == NULL || b->candParent == NULL || b->candVertex == NULL || b->candHash == NULL
+        || b->heap == NULL || b->heapPos == NULL || b->table == NULL || b->zobrist == NULL){
+        hkBeamFree(b);
+        return NULL;
+    }
+    rng r;
+    rngInit(&r, 1, 0);
+    for (int i=0; i<n; i++) b->zobrist[i] = rngNext64(&r);
+    return b;
+}
+
+void hkBeamFree(hkBeam* b){
+    if (b == NULL) return;
+    for (int l=0; l<2; l++){
+        free(b->sets[l]);
+        free(b->hashes[l]);
+        free(b->values[l]);
+        free(b->vertices[l]);
+    }
+    free(b->parents);
+    free(b->candValue);
+    free(b->candParent);
+    free(b->candVertex);
+    free(b->candHash);
+    free(b->heap);
+    free(b->heapPos);
+    free(b->table);
+    free(b->zobrist);
+    free(b);
+}
+
+size_t hkBeamBytes(const hkBeam* b){
+    // Postcondition: return the number of bytes of the tables of b
+    size_t perState = 2*(b->words*sizeof(uint64_t) + sizeof(uint64_t) + 2*sizeof(int32_t))
+                      + (size_t)b->n*sizeof(beamParent) + 5*sizeof(int32_t) + sizeof(uint64_t);
+    return b->width*perState + (b->tableMask + 1)*sizeof(int32_t) + b->n*sizeof(uint64_t);
+}
+
+static inline bool isVisited(const uint64_t* s, int v){
+    return (s[v >> 6] >> (v & 63)) & 1;
+}
+
+// max-heap of the candidate slots on their values
+
+static inline void heapSet(hkBeam* b, int h, int32_t slot){
+    b->heap[h] = slot;
+    b->heapPos[slot] = h;
+}
+
+static void siftUp(hkBeam* b, int h){
+    int32_t slot = b->heap[h];
+    while (h > 0 && b->candValue[b->heap[(h-1)/2]] < b->candValue[slot]){
+        heapSet(b, h, b->heap[(h-1)/2]);
+        h = (h-1)/2;
+    }
+    heapSet(b, h, slot);
+}
+
+static void siftDown(hkBeam* b, int h, int size){
+    int32_t slot = b->heap[h];
+    while (2*h+1 < size){
+        int c = 2*h+1;
+        if (c+1 < size && b->candValue[b->heap[c+1]] > b->candValue[b->heap[c]]) c++;
+        if (b->candValue[b->heap[c]] <= b->candValue[slot]) break;
+        heapSet(b, h, b->heap[c]);
+        h = c;
+    }
+    heapSet(b, h, slot);
+}
+
+// hash table of the candidates, with linear probing
+
+static bool sameState(const hkBeam* b, int32_t slot, int32_t parent, int vertex, uint64_t hash){
+    // Postcondition: return true if candidate slot is the state reached from parent by adding vertex
+    // (vertex is in neither parent set, so both sets are equal if their parents' sets are)
+    if (b->candVertex[slot] != vertex || b->candHash[slot] != hash) return false;
+    const uint64_t* a = b->sets[0] + (size_t)b->candParent[slot]*b->words;
+    const uint64_t* c = b->sets[0] + (size_t)parent*b->words;
+    return memcmp(a, c, b->words*sizeof(uint64_t)) == 0;
+}
+
+static inline size_t homeCell(const hkBeam* b, uint64_t hash, int vertex){
+    // Postcondition: return the first cell probed for the state (vertex, set of hash)
+    // (the vertex is mixed in, otherwise the states of a same set would all share one probe sequence)
+    uint64_t h = (hash ^ (vertex * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+    return (h ^ (h >> 31)) & b->tableMask;
+}
+
+static size_t findCell(const hkBeam* b, int32_t parent, int vertex, uint64_t hash){
+    // Postcondition: return the cell of the state, or the empty cell where it would be inserted
+    size_t c = homeCell(b, hash, vertex);
+    while (b->table[c] >= 0 && !sameState(b, b->table[c], parent, vertex, hash)) c = (c + 1) & b->tableMask;
+    return c;
+}
+
+static void removeCell(hkBeam* b, size_t c){
+    // Postcondition: cell c is emptied, and the following cells of its cluster are moved back so that they can still be found
+    size_t hole = c;
+    b->table[hole] = -1;
+    for (size_t d = (hole + 1) & b->tableMask; b->table[d] >= 0; d = (d + 1) & b->tableMask){
+        size_t home = homeCell(b, b->candHash[b->table[d]], b->candVertex[b->table[d]]);
+        // move d to the hole if its home is not in (hole, d]
+        if (((d - home) & b->tableMask) >= ((d - hole) & b->tableMask)){
+            b->table[hole] = b->table[d];
+            b->table[d] = -1;
+            hole = d;
+        }
+    }
+}
+
+static void offer(hkBeam* b, int32_t parent, int vertex, int value, int* size, beamStats* stats){
+    // Postcondition: the state reached from parent by adding vertex, with value, is among the candidates if it is one of the B best
+    uint64_t hash = b->hashes[0][parent] ^ b->zobrist[vertex];
+    stats->generated++;
+    size_t c = findCell(b, parent, vertex, hash);
+    int32_t slot = b->table[c];
+    if (slot >= 0){
+        stats->merged++;
+        if (value < b->candValue[slot]){
+            b->candValue[slot] = value;
+            b->candParent[slot] = parent;
+            siftDown(b, b->heapPos[slot], *size);
+        }
+        return;
+    }
+    if (*size == b->width){
+        int32_t worst = b->heap[0];
+        if (value >= b->candValue[worst]) return;
+        removeCell(b, findCell(b, b->candParent[worst], b->candVertex[worst], b->candHash[worst]));
+        stats->evicted++;
+        c = findCell(b, parent, vertex, hash); // the cluster may have moved
+        slot = worst;
+        b->candValue[slot] = value;
+        b->candParent[slot] = parent;
+        b->candVertex[slot] = vertex;
+        b->candHash[slot] = hash;
+        b->table[c] = slot;
+        siftDown(b, 0, *size);
+        return;
+    }
+    slot = (*size)++;
+    b->candValue[slot] = value;
+    b->candParent[slot] = parent;
+    b->candVertex[slot] = vertex;
+    b->candHash[slot] = hash;
+    b->table[c] = slot;
+    heapSet(b, slot, slot);
+    siftUp(b, slot);
+}
+
+/**
+ * Beam Held-Karp algorithm
+ * Output: tour[0..n-1] is the tour found, starting from the depot (0), and stats (if not NULL) is filled
+ * Return its length
+ */
+int heldKarp_beam(int n, const costProvider* cost, hkBeam* b, int* tour, beamStats* stats){
+    beamStats local;
+    if (stats == NULL) stats = &local;
+    *stats = (beamStats){0};
+    int words = b->words;
+    // layer 0: the path reduced to the depot
+    memset(b->sets[0], 0, words*sizeof(uint64_t));
+    b->sets[0][0] = 1;
+    b->hashes[0][0] = b->zobrist[0];
+    b->values[0][0] = 0;
+    b->vertices[0][0] = 0;
+    b->count[0] = 1;
+    for (int k=1; k<n; k++){
+        int size = 0;
+        for (size_t c=0; c<=b->tableMask; c++) b->table[c] = -1;
+        for (int s=0; s<b->count[0]; s++){
+            const uint64_t* S = b->sets[0] + (size_t)s*words;
+            for (int j=1; j<n; j++){
+                if (isVisited(S, j)) continue;
+                offer(b, s, j, b->values[0][s] + costOf(cost, b->vertices[0][s], j), &size, stats);
+            }
+        }
+        // the candidates become layer k
+        for (int s=0; s<size; s++){
+            int32_t p = b->candParent[s];
+            uint64_t* S = b->sets[1] + (size_t)s*words;
+            memcpy(S, b->sets[0] + (size_t)p*words, words*sizeof(uint64_t));
+            S[b->candVertex[s] >> 6] |= (uint64_t)1 << (b->candVertex[s] & 63);
+            b->hashes[1][s] = b->candHash[s];
+            b->values[1][s] = b->candValue[s];
+            b->vertices[1][s] = b->candVertex[s];
+            b->parents[(size_t)k*b->width + s] = (beamParent){p, b->candVertex[s]};
+        }
+        b->count[1] = size;
+        // swap the layers
+        uint64_t* t = b->sets[0]; b->sets[0] = b->sets[1]; b->sets[1] = t;
+        t = b->hashes[0]; b->hashes[0] = b->hashes[1]; b->hashes[1] = t;
+        int32_t* v = b->values[0]; b->values[0] = b->values[1]; b->values[1] = v;
+        v = b->vertices[0]; b->vertices[0] = b->vertices[1]; b->vertices[1] = v;
+        b->count[0] = size;
+    }
+
+    // return to the depot (0)
+    int best = INT_MAX, bests = -1;
+    for (int s=0; s<b->count[0]; s++){
+        int length = b->values[0][s] + costOf(cost, b->vertices[0][s], 0);
+        if (length < best){
+            best = length;
+            bests = s;
+        }
+    }
+    tour[0] = 0;
+    for (int k=n-1, s=bests; k>=1; k--){
+        beamParent p = b->parents[(size_t)k*b->width + s];
+        tour[k] = p.vertex;
+        s = p.parent;
+    }
+    return best;
+}
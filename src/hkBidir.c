@@ -0,0 +1,177 @@
+/*
+ Bidirectional (meet-in-the-middle) bottom-up Held-Karp algorithm for symmetric costs
+
+ When costs are symmetric, cell (i,S) is also the length of the smallest path from the depot (0)
+ through S to i, so the forward DP from the depot and the backward one towards it are the same
+ table. A tour can be cut at any vertex j into two such paths: 0 -> A -> j, then j -> B -> 0,
+ with A and B partitioning the other vertices. With |A| = half = ceil((n-2)/2) and |B| = n-2-half,
+ both halves are cells of layers half and n-2-half <= half, so only the layers of at most half
+ vertices are computed, and the length of the tour is the minimum over the subsets A of layer half
+ and the vertices j not in A of dp(j,A) + dp(j, the remaining vertices).
+ As in heldKarp_compact, the costs only keep two consecutive layers, which are the two middle
+ layers at the end, and a subset S of size k only has the n-1-k cells of the vertices not in S,
+ stored at rank(S)*(n-1-k) + (number of such vertices smaller than i). The successors of the lower
+ half of the lattice are kept to rebuild both halves of the tour.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "hkBidir.h"
+#include "hkTable.h"
+#include "timer.h"
+#include "instrument.h"
+
+hkBidir* hkBidirCreate(int n){
+    // Precondition: 2 <= n <= 32
+    // Postcondition: return the successor table of the lower half of the lattice, or NULL if there is not enough memory
+    hkBidir* b = (hkBidir*) malloc(sizeof(hkBidir));
+    if (b == NULL) return NULL;
+    b->n = n;
+    b->half = (n-1)/2; // ceil((n-2)/2)
+    b->layerOffset[0] = 0;
+    for (int k=0; k<n; k++)
+        b->layerOffset[k+1] = b->layerOffset[k] + binom[n-1][k]*(n-1-k);
+    b->succ = (uint8_t*) malloc(b->layerOffset[b->half+1]);
+    if (b->succ == NULL){
+        free(b);
+        return NULL;
+    }
+    b->middleSet = 0;
+    b->middleVertex = -1;
+    b->peakTableBytes = b->layerOffset[b->half+1];
+    return b;
+}
+
+void hkBidirFree(hkBidir* b){
+    if (b == NULL) return;
+    free(b->succ);
+    free(b);
+}
+
+static inline int32_t cellOf(const int32_t* layer, int n, int i, set S){
+    // Postcondition: return cell (i,S) of the layer of the subsets of the size of S
+    return layer[rankSet(S)*(n-1-setSize(S)) + compactPosition(i,S)];
+}
+
+/**
+ * Bidirectional Held-Karp algorithm
+ * Precondition: costOf(cost, i, j) = costOf(cost, j, i) for all i, j
+ * Returns the length of the smallest tour, or -1 if a layer cannot be allocated.
+ */
+int heldKarp_bidir(int n, const costProvider* cost, hkBidir* b){
+    int half = b->half;
+    size_t succBytes = b->layerOffset[half+1];
+
+    // layer 0: go back to the depot (0) from i
+    INSTR_START(tInit);
+    int32_t* prev = NULL;
+    int32_t* cur = (int32_t*) malloc((n-1)*sizeof(int32_t));
+    if (cur == NULL) return -1;
+    for (int i=1; i<n; i++){
+        cur[i-1] = costOf(cost, i, 0);
+        b->succ[i-1] = 0;
+    }
+    size_t curBytes = (n-1)*sizeof(int32_t);
+    INSTR_PHASE(PHASE_INIT, tInit);
+
+    int bit[32];
+    size_t cell[32];
+    int32_t val[32];
+    set ALL = createSet(n);
+    INSTR_START(tSweep);
+    for (int k=1; k<=half; k++){
+        INSTR_START(start);
+        free(prev); // layer k-2 is not needed anymore
+        prev = cur;
+        size_t prevBytes = curBytes;
+        int width = n-1-k;      // number of cells of a subset of layer k
+        size_t nbSets = binom[n-1][k];
+        curBytes = nbSets*width*sizeof(int32_t);
+        cur = (int32_t*) malloc(curBytes);
+        if (cur == NULL){
+            free(prev);
+            return -1;
+        }
+        if (succBytes + prevBytes + curBytes > b->peakTableBytes) b->peakTableBytes = succBytes + prevBytes + curBytes;
+        INSTR_COUNT(COUNTER_STATES, nbSets*(uint64_t)width);
+
+        uint8_t* succ = b->succ + b->layerOffset[k];
+        set S = createSet(k+1); // first subset of size k in colex order
+        for (size_t r=0; r<nbSets; r++, S = nextSetOfSameSize(S)){
+            compactPredecessors(n, S, k, bit, cell);
+            for (int m=0; m<k; m++) val[m] = prev[cell[m]];
+            size_t base = r*width;
+            int p = 0;
+            int i;
+            forEachElement(i, ALL & ~S){
+                int32_t best = INT32_MAX;
+                int bestj = 0;
+                for (int m=0; m<k; m++){
+                    int32_t alt = costOf(cost, i, bit[m]+1) + val[m];
+                    if (alt < best){
+                        best = alt;
+                        bestj = bit[m]+1;
+                    }
+                }
+                cur[base+p] = best;
+                succ[base+p] = bestj;
+                p++;
+            }
+        }
+        INSTR_LAYER(k, start);
+    }
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+
+    // join the two halves: 0 -> A -> j (cell (j,A) of layer half) and j -> B -> 0 (layer n-2-half)
+    const int32_t* other = (n-2-half == half) ? cur : prev;
+    int width = n-1-half;
+    size_t nbSets = binom[n-1][half];
+    int32_t best = INT32_MAX;
+    set A = createSet(half+1);
+    for (size_t r=0; r<nbSets; r++){
+        int j, p = 0;
+        forEachElement(j, ALL & ~A){
+            int32_t alt = cur[r*width + p++] + cellOf(other, n, j, removeElement(ALL & ~A, j));
+            if (alt < best){
+                best = alt;
+                b->middleSet = A;
+                b->middleVertex = j;
+            }
+        }
+        if (r+1 < nbSets) A = nextSetOfSameSize(A); // A may be the empty set, which has no successor
+    }
+    free(prev);
+    free(cur);
+    return best;
+}
+
+static int followSucc(const hkBidir* b, int i, set S, int* path){
+    // Postcondition: path[0..|S|-1] = the vertices of S in the order of the smallest path from i through S to 0;
+    //                return |S|
+    int n = b->n;
+    int len = 0;
+    while (!isEmpty(S)){
+        int k = setSize(S);
+        i = b->succ[b->layerOffset[k] + rankSet(S)*(n-1-k) + compactPosition(i,S)];
+        path[len++] = i;
+        S = removeElement(S, i);
+    }
+    return len;
+}
+
+void tour_bidir(const hkBidir* b, int* tour){
+    // Postcondition: tour[0..n-1] is the tour computed by heldKarp_bidir, starting from the depot (0)
+    INSTR_START(start);
+    int n = b->n;
+    int j = b->middleVertex;
+    set A = b->middleSet;
+    int path[32];
+    // the path from j through A to 0, reversed, goes from 0 to j
+    int len = followSucc(b, j, A, path);
+    tour[0] = 0;
+    for (int p=0; p<len; p++) tour[1+p] = path[len-1-p];
+    tour[1+len] = j;
+    followSucc(b, j, removeElement(createSet(n) & ~A, j), tour + 2 + len);
+    INSTR_PHASE(PHASE_RECONSTRUCT, start);
+}
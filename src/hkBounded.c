@@ -0,0 +1,152 @@
+/*
+ Memoised DP with branch-and-bound pruning
+
+ computeD_memo computes D(i,s), the cost of the smallest path from i to 0 visiting s, for every
+ state reachable from (0,{1,...,n-1}). Here each call receives a budget: the length of the best
+ known tour minus the cost of the path already built from 0 to i. A state whose lower bound
+ reaches its budget cannot lead to a better tour and is not expanded.
+ The result of computeD_bounded is exact when it is smaller than the budget; otherwise it is
+ only a lower bound of D(i,s). The memoisation table records which of the two it holds, as
+ 2*value + exact. With the sparse backend, only the states actually visited are stored.
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+#include "hkBounded.h"
+#include "localSearch.h"
+
+static inline int edge(int a, int b, const costProvider* cost){
+    // smallest cost between a and b in both directions, so that bounds also hold for asymmetric costs
+    return costOf(cost, a, b) < costOf(cost, b, a) ? costOf(cost, a, b) : costOf(cost, b, a);
+}
+
+/**
+ * Lower bound of D(i,s): a path from i to 0 through s contains a spanning tree of s,
+ * an edge from i to s and an edge from s to 0.
+ * Precondition: s is not empty
+ */
+int lowerBound(int i, set s, const costProvider* cost){
+    int v[SET_BITS];
+    int k = 0;
+    int e;
+    forEachElement(e, s) v[k++] = e;
+
+    int toI = INT_MAX, to0 = INT_MAX;
+    for (int a=0; a<k; a++){
+        if (edge(i, v[a], cost) < toI) toI = edge(i, v[a], cost);
+        if (edge(v[a], 0, cost) < to0) to0 = edge(v[a], 0, cost);
+    }
+
+    // Prim's algorithm on the complete graph of s
+    int dist[SET_BITS];
+    bool inTree[SET_BITS];
+    for (int a=0; a<k; a++){
+        dist[a] = edge(v[0], v[a], cost);
+        inTree[a] = false;
+    }
+    inTree[0] = true;
+    int mst = 0;
+    for (int step=1; step<k; step++){
+        int best = -1;
+        for (int a=0; a<k; a++)
+            if (!inTree[a] && (best < 0 || dist[a] < dist[best])) best = a;
+        inTree[best] = true;
+        mst += dist[best];
+        for (int a=0; a<k; a++)
+            if (!inTree[a] && edge(v[best], v[a], cost) < dist[a]) dist[a] = edge(v[best], v[a], cost);
+    }
+    return toI + mst + to0;
+}
+
+/**
+ * computeD_memo version with a budget
+ * Preconditions: isIn(i,s) = false and isIn(0,s) = false, budget > 0
+ * Postrelation: return D(i,s) if D(i,s) < budget, or a value v such that budget <= v <= D(i,s)
+ */
+int computeD_bounded(int i, set s, int budget, int n, const costProvider* cost, memoTable* memo, bbStats* stats){
+    if (isEmpty(s)) return costOf(cost, i, 0);
+    int m;
+    bool known = memoGet(memo, i, s, &m);
+    if (known && ((m & 1) || (m >> 1) >= budget)){
+        stats->reused++;
+        return m >> 1;
+    }
+    int lb = lowerBound(i, s, cost);
+    if (lb >= budget){
+        stats->pruned++;
+        if (!known || lb > (m >> 1)) memoPut(memo, i, s, lb << 1);
+        return lb;
+    }
+    stats->expanded++;
+
+    // successors by increasing cost, so that a good path is found early and tightens the budget
+    int js[SET_BITS];
+    int k = 0;
+    int j;
+    forEachElement(j, s){
+        int p = k++;
+        while (p > 0 && costOf(cost, i, js[p-1]) > costOf(cost, i, j)){
+            js[p] = js[p-1];
+            p--;
+        }
+        js[p] = j;
+    }
+
+    int best = INT_MAX;
+    for (int a=0; a<k; a++){
+        int bound = (best < budget ? best : budget) - costOf(cost, i, js[a]);
+        if (bound <= 0) break; // the successors are sorted: the next ones cannot do better
+        int d = computeD_bounded(js[a], removeElement(s, js[a]), bound, n, cost, memo, stats);
+        if (d < bound) best = costOf(cost, i, js[a]) + d;
+    }
+    if (best < budget){
+        memoPut(memo, i, s, (best << 1) | 1);
+        return best;
+    }
+    // every successor path costs at least the budget
+    memoPut(memo, i, s, budget << 1);
+    return budget;
+}
+
+static int successor(int i, set s, int d, const costProvider* cost, memoTable* memo){
+    // Precondition: d = D(i,s) is exact and s is not empty
+    // Postcondition: return a vertex j of s such that cost[i][j] + D(j, s\{j}) = d
+    int j;
+    forEachElement(j, s){
+        set rest = removeElement(s, j);
+        int m = 0;
+        if (isEmpty(rest)) m = (costOf(cost, j, 0) << 1) | 1;
+        else if (!memoGet(memo, j, rest, &m)) continue;
+        if ((m & 1) && costOf(cost, i, j) + (m >> 1) == d) return j;
+    }
+    return -1;
+}
+
+/**
+ * Bounded DP seeded with a 2-opt local optimum
+ * Precondition: memo is empty
+ * Output: sol[0..n-1] is an optimal tour starting from 0
+ * Return its length
+ */
+int solveBounded(int n, const costProvider* cost, memoTable* memo, int* sol, bbStats* stats){
+    stats->expanded = stats->pruned = stats->reused = 0;
+    int incumbent = nearestNeighbourTour(n, cost, sol);
+    incumbent = greedyLS2(n, sol, incumbent, cost, NULL);
+    if (n < 3) return incumbent;
+
+    set s = createSet(n);
+    int d = computeD_bounded(0, s, incumbent, n, cost, memo, stats);
+    if (d < incumbent){
+        // rebuild the improving tour from the exact values of the table
+        int i = 0;
+        for (int k=1; k<n; k++){
+            int j = successor(i, s, d, cost, memo);
+            sol[k] = j;
+            d -= costOf(cost, i, j);
+            s = removeElement(s, j);
+            i = j;
+        }
+        sol[0] = 0;
+    } // otherwise, no tour is shorter than the local optimum, which is kept in sol
+    return compute_sol_length(sol, n, cost);
+}
@@ -0,0 +1,167 @@
+/*
+ Low-memory bottom-up Held-Karp algorithm
+
+ heldKarp_iter keeps two int tables of n*2^(n-1) cells. This version only keeps:
+ - the costs of two consecutive layers (layer k-1 is freed as soon as layer k is computed),
+   on 16 bits when the length of a heuristic tour fits, on 32 bits otherwise;
+ - the successors of all layers, packed on 5 bits each, which is all the tour reconstruction needs.
+ In both tables, a subset S of size k only has the n-1-k cells of the vertices i not in S
+ (and different from the depot), stored at rank(S)*(n-1-k) + (number of such vertices smaller than i).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "hkCompact.h"
+#include "hkTable.h"
+#include "localSearch.h"
+
+#define SUCC_BITS 5 // enough for vertices 1..31
+#define SUCC_MASK ((1u << SUCC_BITS) - 1)
+
+static inline uint32_t loadCost(const void* layer, int bytes, size_t idx){
+    if (bytes == 2) return ((const uint16_t*)layer)[idx];
+    return ((const uint32_t*)layer)[idx];
+}
+
+static inline void storeCost(void* layer, int bytes, size_t idx, uint32_t v){
+    if (bytes == 2) ((uint16_t*)layer)[idx] = (uint16_t)v;
+    else ((uint32_t*)layer)[idx] = v;
+}
+
+static inline void storeSucc(uint64_t* words, size_t idx, uint32_t v){
+    // Precondition: the SUCC_BITS bits of cell idx are 0
+    size_t b = idx*SUCC_BITS;
+    int off = b & 63;
+    words[b >> 6] |= (uint64_t)v << off;
+    if (off > 64-SUCC_BITS) words[(b >> 6) + 1] |= (uint64_t)v >> (64-off);
+}
+
+static inline uint32_t loadSucc(const uint64_t* words, size_t idx){
+    size_t b = idx*SUCC_BITS;
+    int off = b & 63;
+    uint64_t v = words[b >> 6] >> off;
+    if (off > 64-SUCC_BITS) v |= words[(b >> 6) + 1] << (64-off);
+    return (uint32_t)v & SUCC_MASK;
+}
+
+hkCompact* hkCompactCreate(int n, const costProvider* cost){
+    // Precondition: 2 <= n <= 32
+    // Postcondition: return the successor store for n vertices, or NULL if there is not enough memory
+    hkCompact* c = (hkCompact*) malloc(sizeof(hkCompact));
+    if (c == NULL) return NULL;
+    c->n = n;
+    int sol[n];
+    c->upperBound = nearestNeighbourTour(n, cost, sol);
+    c->costBytes = (c->upperBound < UINT16_MAX) ? 2 : 4;
+    c->layerOffset[0] = 0;
+    for (int k=0; k<n; k++)
+        c->layerOffset[k+1] = c->layerOffset[k] + binom[n-1][k]*(n-1-k);
+    size_t nbWords = (c->layerOffset[n]*SUCC_BITS + 63)/64 + 1;
+    c->succ = (uint64_t*) calloc(nbWords, sizeof(uint64_t));
+    if (c->succ == NULL){
+        free(c);
+        return NULL;
+    }
+    c->firstVertex = -1;
+    c->peakTableBytes = nbWords*sizeof(uint64_t);
+    return c;
+}
+
+void hkCompactFree(hkCompact* c){
+    if (c == NULL) return;
+    free(c->succ);
+    free(c);
+}
+
+/**
+ * Held-Karp algorithm with a rolling window of two cost layers
+ * Returns the length of the smallest tour, or -1 if a layer cannot be allocated.
+ * A cost cell greater than the upper bound cannot belong to a tour shorter than the heuristic one,
+ * so it is stored as "infinite" (the largest value of the cell width).
+ */
+int heldKarp_compact(int n, const costProvider* cost, hkCompact* c){
+    int bytes = c->costBytes;
+    uint32_t INF = (bytes == 2) ? UINT16_MAX : UINT32_MAX;
+    uint32_t UB = (uint32_t)c->upperBound;
+    size_t succBytes = ((c->layerOffset[n]*SUCC_BITS + 63)/64 + 1)*sizeof(uint64_t);
+
+    // layer 0: go back to the depot (0) from i
+    void* prev = malloc((n-1)*bytes);
+    if (prev == NULL) return -1;
+    for (int i=1; i<n; i++) storeCost(prev, bytes, i-1, (uint32_t)costOf(cost, i, 0) <= UB ? (uint32_t)costOf(cost, i, 0) : INF);
+    size_t prevBytes = (n-1)*bytes;
+
+    int bit[32];
+    size_t cell[32];
+    uint32_t val[32];
+    set ALL = createSet(n);
+    for (int k=1; k<n-1; k++){
+        int width = n-1-k;      // number of cells of a subset of layer k
+        size_t curBytes = binom[n-1][k]*width*bytes;
+        void* cur = malloc(curBytes);
+        if (cur == NULL){
+            free(prev);
+            return -1;
+        }
+        if (succBytes + prevBytes + curBytes > c->peakTableBytes) c->peakTableBytes = succBytes + prevBytes + curBytes;
+
+        set S = createSet(k+1); // first subset of size k in colex order
+        size_t nbSets = binom[n-1][k];
+        for (size_t r=0; r<nbSets; r++, S = nextSetOfSameSize(S)){
+            compactPredecessors(n, S, k, bit, cell);
+            for (int m=0; m<k; m++) val[m] = loadCost(prev, bytes, cell[m]);
+
+            size_t base = r*width;
+            int p = 0;
+            int i;
+            forEachElement(i, ALL & ~S){
+                uint32_t best = INF;
+                int bestj = 0;
+                for (int m=0; m<k; m++){
+                    if (val[m] == INF) continue;
+                    uint32_t alt = (uint32_t)costOf(cost, i, bit[m]+1) + val[m];
+                    if (alt < best){
+                        best = alt;
+                        bestj = bit[m]+1;
+                    }
+                }
+                storeCost(cur, bytes, base+p, best <= UB ? best : INF);
+                storeSucc(c->succ, c->layerOffset[k] + base+p, bestj);
+                p++;
+            }
+        }
+        free(prev); // layer k-1 is not needed anymore
+        prev = cur;
+        prevBytes = curBytes;
+    }
+
+    // return to depot (0): vertex j is the only cell of {1,...,n-1} \ {j}
+    uint32_t best = INF;
+    for (int j=1; j<n; j++){
+        uint32_t val = loadCost(prev, bytes, rankSet(removeElement(ALL,j)));
+        if (val == INF) continue;
+        uint32_t alt = (uint32_t)costOf(cost, 0, j) + val;
+        if (alt < best){
+            best = alt;
+            c->firstVertex = j;
+        }
+    }
+    free(prev);
+    return (int)best;
+}
+
+void printTour_compact(const hkCompact* c){
+    // Postcondition: print the tour computed by heldKarp_compact, starting from the depot (0)
+    int n = c->n;
+    set S = createSet(n);
+    int i = c->firstVertex;
+    printf("Circuit : 0");
+    for (int k=n-2; k>=0 && i>0; k--){
+        printf(" %d", i);
+        S = removeElement(S, i);
+        if (k == 0) break;
+        i = loadSucc(c->succ, c->layerOffset[k] + rankSet(S)*(n-1-k) + compactPosition(i,S));
+    }
+    printf(" 0\n");
+}
@@ -0,0 +1,232 @@
+/*
+ Out-of-core bottom-up Held-Karp algorithm
+
+ Layer k of the bottom-up recurrence only reads layer k-1, but heldKarp_iter keeps the n*2^(n-1)
+ cells of dp and succ in memory. Here, each layer of costs is written sequentially to its own file,
+ in the layout of heldKarp_compact: the subsets of size k in colex order (their combinatorial rank),
+ and for each of them the n-1-k cells of the vertices i not in S. While layer k is computed, layer
+ k-1 is mapped read-only: as S goes through the ranks, each of the k subsets S\{j} moves forward in
+ layer k-1, so the mapping is read as a few sequential streams and its pages belong to the page
+ cache, which the kernel can evict, instead of to the process. Layer k-1 is deleted once layer k
+ is written. The successors (one byte per cell) are appended to a single file, which is only read
+ back, one cell per vertex, to rebuild the tour. The process only holds two write buffers; the
+ disk holds two cost layers and the successors written so far (about 70 GB at the peak for n = 32).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include "hkDisk.h"
+#include "hkTable.h"
+#include "timer.h"
+#include "instrument.h"
+
+#define WRITE_BUFFER_BYTES ((size_t)8 << 20)
+
+typedef struct {
+    int fd;
+    char* buffer;
+    size_t used;
+    size_t size;
+    uint64_t* written;  // counter of the bytes written
+    bool failed;
+} layerWriter;
+
+static int openTemp(const char* dir){
+    // Postcondition: return the descriptor of a new file of dir, already unlinked so that it disappears once closed, or -1
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/hkLayer-XXXXXX", dir) >= (int)sizeof(path)) return -1;
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    return fd;
+}
+
+static void flush(layerWriter* w){
+    // Postcondition: the buffer of w is written to its file (w->failed is set if it cannot be)
+    const char* p = w->buffer;
+    size_t bytes = w->used;
+    while (bytes > 0 && !w->failed){
+        ssize_t done = write(w->fd, p, bytes);
+        if (done < 0){
+            if (errno != EINTR) w->failed = true;
+            continue;
+        }
+        p += done;
+        bytes -= done;
+    }
+    *w->written += w->used;
+    w->used = 0;
+}
+
+static inline void putCost(layerWriter* w, int32_t v){
+    if (w->used + sizeof(v) > w->size) flush(w);
+    memcpy(w->buffer + w->used, &v, sizeof(v));
+    w->used += sizeof(v);
+}
+
+static inline void putSucc(layerWriter* w, uint8_t v){
+    if (w->used == w->size) flush(w);
+    w->buffer[w->used++] = (char)v;
+}
+
+hkDisk* hkDiskCreate(int n, const char* dir){
+    // Precondition: 2 <= n <= 32
+    // Postcondition: return the successor file of n vertices in dir, or NULL if it cannot be created
+    hkDisk* d = (hkDisk*) calloc(1, sizeof(hkDisk));
+    if (d == NULL) return NULL;
+    d->n = n;
+    d->dir = dir;
+    d->succFd = openTemp(dir);
+    if (d->succFd < 0){
+        free(d);
+        return NULL;
+    }
+    d->layerOffset[0] = 0;
+    for (int k=0; k<n; k++)
+        d->layerOffset[k+1] = d->layerOffset[k] + binom[n-1][k]*(n-1-k);
+    d->firstVertex = -1;
+    d->bufferBytes = WRITE_BUFFER_BYTES;
+    return d;
+}
+
+void hkDiskFree(hkDisk* d){
+    if (d == NULL) return;
+    close(d->succFd);
+    free(d);
+}
+
+/**
+ * Held-Karp algorithm with the layers streamed to files
+ * If layerTime is not NULL, layerTime[k] is set to the wall-clock time spent on layer k.
+ * Returns the length of the smallest tour, or -1 if a layer cannot be written or mapped.
+ */
+int heldKarp_disk(int n, const costProvider* cost, hkDisk* d, double* layerTime){
+    char* buffers = (char*) malloc(2*d->bufferBytes);
+    if (buffers == NULL) return -1;
+    layerWriter succW = {.fd = d->succFd, .buffer = buffers + d->bufferBytes, .size = d->bufferBytes, .written = &d->bytesWritten};
+    layerWriter costW = {.fd = openTemp(d->dir), .buffer = buffers, .size = d->bufferBytes, .written = &d->bytesWritten};
+    int result = -1;
+    if (costW.fd < 0) goto done;
+
+    // layer 0: go back to the depot (0) from i
+    INSTR_START(tInit);
+    for (int i=1; i<n; i++){
+        putCost(&costW, costOf(cost, i, 0));
+        putSucc(&succW, 0);
+    }
+    flush(&costW);
+    INSTR_PHASE(PHASE_INIT, tInit);
+    int prevFd = costW.fd;
+    if (costW.failed){
+        close(prevFd);
+        goto done;
+    }
+    size_t prevBytes = (n-1)*sizeof(int32_t);
+
+    int bit[32];
+    size_t cell[32];
+    int32_t val[32];
+    set ALL = createSet(n);
+    INSTR_START(tSweep);
+    for (int k=1; k<n-1; k++){
+        double start = wallTime();
+        const int32_t* prev = (const int32_t*) mmap(NULL, prevBytes, PROT_READ, MAP_SHARED, prevFd, 0);
+        costW.fd = openTemp(d->dir);
+        if (prev == MAP_FAILED || costW.fd < 0){
+            if (prev != MAP_FAILED) munmap((void*)prev, prevBytes);
+            close(prevFd);
+            goto done;
+        }
+        d->bytesMapped += prevBytes;
+
+        int width = n-1-k;      // number of cells of a subset of layer k
+        size_t nbSets = binom[n-1][k];
+        size_t curBytes = nbSets*width*sizeof(int32_t);
+        INSTR_COUNT(COUNTER_STATES, nbSets*(uint64_t)width);
+        set S = createSet(k+1); // first subset of size k in colex order
+        for (size_t r=0; r<nbSets; r++, S = nextSetOfSameSize(S)){
+            compactPredecessors(n, S, k, bit, cell);
+            for (int m=0; m<k; m++) val[m] = prev[cell[m]];
+            int i;
+            forEachElement(i, ALL & ~S){
+                int32_t best = INT32_MAX;
+                int bestj = 0;
+                for (int m=0; m<k; m++){
+                    int32_t alt = costOf(cost, i, bit[m]+1) + val[m];
+                    if (alt < best){
+                        best = alt;
+                        bestj = bit[m]+1;
+                    }
+                }
+                putCost(&costW, best);
+                putSucc(&succW, bestj);
+            }
+        }
+        flush(&costW);
+        size_t diskBytes = prevBytes + curBytes + d->layerOffset[k+1];
+        if (diskBytes > d->peakDiskBytes) d->peakDiskBytes = diskBytes;
+        munmap((void*)prev, prevBytes);
+        close(prevFd); // layer k-1 is not needed anymore
+        prevFd = costW.fd;
+        prevBytes = curBytes;
+        if (costW.failed){
+            close(prevFd);
+            goto done;
+        }
+        if (layerTime != NULL) layerTime[k] = wallTime() - start;
+        INSTR_LAYER(k, start);
+    }
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+    flush(&succW);
+
+    // return to depot (0): vertex j is the only cell of {1,...,n-1} \ {j}
+    const int32_t* prev = (const int32_t*) mmap(NULL, prevBytes, PROT_READ, MAP_SHARED, prevFd, 0);
+    if (prev != MAP_FAILED && !succW.failed){
+        d->bytesMapped += prevBytes;
+        int32_t best = INT32_MAX;
+        for (int j=1; j<n; j++){
+            int32_t alt = costOf(cost, 0, j) + prev[rankSet(removeElement(ALL,j))];
+            if (alt < best){
+                best = alt;
+                d->firstVertex = j;
+            }
+        }
+        result = best;
+    }
+    if (prev != MAP_FAILED) munmap((void*)prev, prevBytes);
+    close(prevFd);
+done:
+    free(buffers);
+    return result;
+}
+
+void printTour_disk(const hkDisk* d){
+    // Postcondition: print the tour computed by heldKarp_disk, starting from the depot (0),
+    //                reading one successor of each layer from the file
+    INSTR_START(start);
+    int n = d->n;
+    set S = createSet(n);
+    int i = d->firstVertex;
+    printf("Circuit : 0");
+    for (int k=n-2; k>=0 && i>0; k--){
+        printf(" %d", i);
+        S = removeElement(S, i);
+        if (k == 0) break;
+        uint8_t next;
+        off_t cell = d->layerOffset[k] + rankSet(S)*(n-1-k) + compactPosition(i,S);
+        if (pread(d->succFd, &next, 1, cell) != 1){
+            printf(" ?");
+            break;
+        }
+        i = next;
+    }
+    printf(" 0\n");
+    INSTR_PHASE(PHASE_RECONSTRUCT, start);
+}
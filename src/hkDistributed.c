@@ -0,0 +1,246 @@
+/*
+ Multi-process bottom-up Held-Karp algorithm: the layers are shared over local sockets
+
+ The coordinator forks nbWorkers processes, each connected to it by a Unix-domain socket pair;
+ all of them inherit the costs. The subsets of each layer k are split by rank (colex order, see
+ rankSet) into nbWorkers contiguous shares. Each worker computes the cells of its share from layer
+ k-1, sends them to the coordinator, and waits for the whole layer k, which the coordinator gathers
+ in rank order and sends back to every worker: the next layer may need any cell of this one. Cells
+ travel without their indices: a layer is the sequence, for its subsets S in rank order, of the
+ cells (i,S) of the vertices i not in S (i > 0), in increasing order of i, which is the compact
+ layer of hkTable.h. A worker only keeps the layer k-1 it reads and its share of layer k, and never
+ writes the rows dp: its memory is two layers, not a table.
+ The coordinator stores each layer in its own rows, does the return to the depot, and rebuilds the
+ tour without a succ table: the successor of (i,S) is recomputed from dp in O(|S|), which is O(n^2)
+ for the whole tour. At the end, each worker sends its compute and communication times per layer.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "hkDistributed.h"
+#include "hkTable.h"
+#include "timer.h"
+#include "instrument.h"
+
+static int sendAll(int fd, const void* data, size_t bytes){
+    // Postcondition: return 0 if the bytes of data are sent to fd, -1 otherwise
+    const char* p = (const char*) data;
+    while (bytes > 0){
+        ssize_t done = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (done < 0){
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += done;
+        bytes -= done;
+    }
+    return 0;
+}
+
+static int recvAll(int fd, void* data, size_t bytes){
+    // Postcondition: return 0 if bytes bytes are received from fd into data, -1 otherwise (error or closed socket)
+    char* p = (char*) data;
+    while (bytes > 0){
+        ssize_t done = recv(fd, p, bytes, 0);
+        if (done < 0 && errno == EINTR) continue;
+        if (done <= 0) return -1;
+        p += done;
+        bytes -= done;
+    }
+    return 0;
+}
+
+static size_t shareStart(int n, int k, int w, int nbWorkers){
+    // Postcondition: return the rank of the first subset of size k of the share of worker w
+    return (size_t)(binom[n-1][k]*w/nbWorkers);
+}
+
+static void computeShare(int n, int k, size_t first, size_t last, const costProvider* cost, const int32_t* prev, int32_t* cells){
+    // Precondition: prev contains layer k-1
+    // Postcondition: cells contains the cells of the subsets of size k whose rank is in [first,last)
+    set ALL = createSet(n);
+    set S = unrankSet(first, k);
+    int bit[32];
+    size_t cell[32];
+    size_t c = 0;
+    for (size_t r=first; r<last; r++, S = nextSetOfSameSize(S)){
+        compactPredecessors(n, S, k, bit, cell);
+        int i;
+        forEachElement(i, ALL & ~S){ // i must not be in S
+            int best = INT_MAX;
+            for (int m=0; m<k; m++){
+                int alt = costOf(cost, i, bit[m]+1) + prev[cell[m]];
+                if (alt < best) best = alt;
+            }
+            cells[c++] = best;
+        }
+    }
+}
+
+static void storeLayer(int n, int k, int** dp, const int32_t* cells){
+    // Postcondition: the cells of layer k are copied into the rows dp
+    set ALL = createSet(n);
+    set S = createSet(k+1); // first subset of size k in colex order
+    size_t nbSets = binom[n-1][k];
+    size_t c = 0;
+    for (size_t r=0; r<nbSets; r++){
+        int i;
+        forEachElement(i, ALL & ~S) dp[i][setIndex(S)] = cells[c++];
+        if (r+1 < nbSets) S = nextSetOfSameSize(S);
+    }
+}
+
+static void runWorker(int fd, int w, int nbWorkers, int n, const costProvider* cost, size_t maxCells){
+    // Postcondition: the worker computes its shares of layers 1..n-2 and sends them to the coordinator on fd,
+    //                then sends its compute and communication times
+    double compute[33] = {0}, communication[33] = {0};
+    size_t maxShare = 0;
+    for (int k=1; k<n-1; k++){
+        size_t share = (shareStart(n, k, w+1, nbWorkers) - shareStart(n, k, w, nbWorkers))*(n-1-k);
+        if (share > maxShare) maxShare = share;
+    }
+    int32_t* prev = (int32_t*) malloc(maxCells*sizeof(int32_t));
+    int32_t* share = (int32_t*) malloc((maxShare > 0 ? maxShare : 1)*sizeof(int32_t));
+    bool ok = (prev != NULL && share != NULL);
+    // layer 0: go back to the depot (0) from i
+    for (int i=1; ok && i<n; i++) prev[i-1] = costOf(cost, i, 0);
+    for (int k=1; ok && k<n-1; k++){
+        size_t first = shareStart(n, k, w, nbWorkers), last = shareStart(n, k, w+1, nbWorkers);
+        size_t width = n-1-k;
+        double start = wallTime();
+        computeShare(n, k, first, last, cost, prev, share);
+        double sent = wallTime();
+        compute[k] = sent - start;
+        ok = sendAll(fd, share, (last - first)*width*sizeof(int32_t)) == 0
+             && recvAll(fd, prev, binom[n-1][k]*width*sizeof(int32_t)) == 0;
+        communication[k] = wallTime() - sent;
+    }
+    free(prev);
+    free(share);
+    if (!ok || sendAll(fd, compute, sizeof(compute)) < 0) return;
+    sendAll(fd, communication, sizeof(communication));
+}
+
+/**
+ * Held-Karp algorithm on nbWorkers processes
+ * Input: dp = n rows of 2^(n-1) integers (allocRows)
+ * Output: tour[0..n-1] is an optimal tour, starting from the depot (0), and stats (if not NULL) is filled
+ * Return the length of the smallest tour, or -1 if the workers cannot be started or a socket fails
+ */
+int heldKarp_distributed(int n, const costProvider* cost, int nbWorkers, int** dp, int* tour, hkDistStats* stats){
+    hkDistStats local;
+    if (stats == NULL) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    set ALL = createSet(n);
+    // base case: go back to the depot (0) from i, in every process
+    for (int i=1; i<n; i++) dp[i][0] = costOf(cost, i, 0);
+
+    size_t maxCells = n-1; // largest layer
+    for (int k=1; k<n-1; k++)
+        if (binom[n-1][k]*(n-1-k) > maxCells) maxCells = binom[n-1][k]*(n-1-k);
+    int32_t* layer = (int32_t*) malloc(maxCells*sizeof(int32_t));
+    int* fds = (int*) malloc(nbWorkers*sizeof(int));
+    pid_t* pids = (pid_t*) malloc(nbWorkers*sizeof(pid_t));
+    if (layer == NULL || fds == NULL || pids == NULL){
+        free(layer);
+        free(fds);
+        free(pids);
+        return -1;
+    }
+    int started = 0;
+    bool ok = true;
+    fflush(stdout); // the workers must not print what the coordinator has buffered
+    while (started < nbWorkers){
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0){
+            ok = false;
+            break;
+        }
+        pid_t pid = fork();
+        if (pid < 0){
+            close(pair[0]);
+            close(pair[1]);
+            ok = false;
+            break;
+        }
+        if (pid == 0){
+            close(pair[0]);
+            for (int w=0; w<started; w++) close(fds[w]);
+            runWorker(pair[1], started, nbWorkers, n, cost, maxCells);
+            _exit(0);
+        }
+        close(pair[1]);
+        fds[started] = pair[0];
+        pids[started++] = pid;
+    }
+
+    // gather each layer in rank order, then send it back to all workers
+    INSTR_START(tSweep);
+    for (int k=1; ok && k<n-1; k++){
+        INSTR_START(start);
+        size_t width = n-1-k;
+        for (int w=0; ok && w<nbWorkers; w++){
+            size_t first = shareStart(n, k, w, nbWorkers), last = shareStart(n, k, w+1, nbWorkers);
+            ok = recvAll(fds[w], layer + first*width, (last - first)*width*sizeof(int32_t)) == 0;
+        }
+        size_t layerBytes = binom[n-1][k]*width*sizeof(int32_t);
+        for (int w=0; ok && w<nbWorkers; w++) ok = sendAll(fds[w], layer, layerBytes) == 0;
+        if (!ok) break;
+        storeLayer(n, k, dp, layer);
+        stats->bytes[k] = (nbWorkers + 1)*(uint64_t)layerBytes; // the shares, then a copy per worker
+        INSTR_COUNT(COUNTER_STATES, binom[n-1][k]*(uint64_t)width);
+        INSTR_LAYER(k, start);
+    }
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+    for (int w=0; ok && w<nbWorkers; w++){
+        double compute[33], communication[33];
+        ok = recvAll(fds[w], compute, sizeof(compute)) == 0 && recvAll(fds[w], communication, sizeof(communication)) == 0;
+        for (int k=1; ok && k<n-1; k++){
+            if (compute[k] > stats->compute[k]) stats->compute[k] = compute[k];
+            stats->communication[k] += communication[k]/nbWorkers;
+        }
+    }
+    for (int w=0; w<started; w++){
+        close(fds[w]);
+        if (!ok) kill(pids[w], SIGTERM);
+        waitpid(pids[w], NULL, 0);
+    }
+    free(layer);
+    free(fds);
+    free(pids);
+    if (!ok) return -1;
+
+    // return to depot (0), and rebuild the tour from dp: the successor of (i,S) is the j of S that gives dp[i][S]
+    INSTR_START(tReconstruct);
+    set S = ALL;
+    int i = 0;
+    int length = INT_MAX;
+    tour[0] = 0;
+    for (int p=1; p<n; p++){
+        int best = INT_MAX;
+        int bestj = -1;
+        int j;
+        forEachElement(j, S){
+            int alt = costOf(cost, i, j) + dp[j][setIndex(removeElement(S,j))];
+            if (alt < best){
+                best = alt;
+                bestj = j;
+            }
+        }
+        if (p == 1) length = best;
+        tour[p] = bestj;
+        S = removeElement(S, bestj);
+        i = bestj;
+    }
+    INSTR_PHASE(PHASE_RECONSTRUCT, tReconstruct);
+    return length;
+}
@@ -0,0 +1,231 @@
+/*
+ Layer-parallel bottom-up Held-Karp algorithm
+
+ The cells of the subsets of size k only depend on the cells of the subsets of size k-1.
+ Each layer is cut into chunks of consecutive ranks, the chunks are dealt to the threads,
+ and a thread that has finished its own chunks steals the remaining chunks of the others.
+ Chunks of a same layer write disjoint cells, so no lock is needed: threads only
+ synchronise on a barrier between two layers.
+ On a NUMA machine, a page is placed on the node of the thread that writes it first. Both
+ hkFirstTouch and heldKarp_parallel pin thread id to the id-th CPU the caller may run on, and
+ hkFirstTouch has thread id write one int per page of the chunks dealt to worker id, so that,
+ as long as the threads do not steal, each worker computes cells stored on the node of its CPU.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "hkParallel.h"
+#include "timer.h"
+#include "instrument.h"
+
+#define MIN_CHUNK 64 // minimum number of subsets per chunk
+
+typedef struct {
+    _Alignas(64) atomic_size_t next; // next chunk to compute
+    size_t end;                      // first chunk that does not belong to this thread
+} chunkQueue;                        // one cache line per thread, to avoid false sharing
+
+typedef struct {
+    hkTable* t;
+    const costProvider* cost;
+    int n;
+    int nbThreads;      // threads actually started
+    chunkQueue* queue;
+    size_t chunkSize;   // number of subsets per chunk in the current layer
+    size_t nbSets;      // number of subsets in the current layer
+    int k;              // size of the subsets of the current layer
+    double* layerTime;
+    double layerStart;
+    pthread_mutex_t start; // held until the barrier is sized to the threads actually started
+    pthread_barrier_t barrier;
+    cpu_set_t allowed;  // CPUs of the calling thread, among which the threads are pinned
+    bool pinned;        // allowed is known
+} parallelContext;
+
+typedef struct {
+    parallelContext* ctx;
+    int id;
+} worker;
+
+static void pinThread(const parallelContext* ctx, int id){
+    // Postcondition: the calling thread only runs on the id-th allowed CPU (modulo their number), if they are known
+    if (!ctx->pinned) return;
+    int target = id % CPU_COUNT(&ctx->allowed);
+    for (int cpu=0; cpu<CPU_SETSIZE; cpu++){
+        if (!CPU_ISSET(cpu, &ctx->allowed) || target-- > 0) continue;
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpu, &one);
+        pthread_setaffinity_np(pthread_self(), sizeof(one), &one); // best effort
+        return;
+    }
+}
+
+static void initPinning(parallelContext* ctx){
+    ctx->pinned = pthread_getaffinity_np(pthread_self(), sizeof(ctx->allowed), &ctx->allowed) == 0
+                  && CPU_COUNT(&ctx->allowed) > 0;
+}
+
+static void endPinning(const parallelContext* ctx){
+    // Postcondition: the calling thread (worker 0) may run on its CPUs again
+    if (ctx->pinned) pthread_setaffinity_np(pthread_self(), sizeof(ctx->allowed), &ctx->allowed);
+}
+
+static size_t chunkSizeOf(size_t nbSets, int nbThreads){
+    // Postcondition: return the number of subsets per chunk of a layer of nbSets subsets
+    size_t chunkSize = nbSets / (16*(size_t)nbThreads);
+    return (chunkSize < MIN_CHUNK) ? MIN_CHUNK : chunkSize;
+}
+
+static void dealChunks(parallelContext* ctx, int k){
+    // Postcondition: the chunks of layer k are split into nbThreads ranges of consecutive chunks
+    ctx->k = k;
+    ctx->nbSets = binom[ctx->n-1][k];
+    ctx->chunkSize = chunkSizeOf(ctx->nbSets, ctx->nbThreads);
+    size_t nbChunks = (ctx->nbSets + ctx->chunkSize - 1) / ctx->chunkSize;
+    for (int w=0; w<ctx->nbThreads; w++){
+        atomic_store_explicit(&ctx->queue[w].next, nbChunks*w/ctx->nbThreads, memory_order_relaxed);
+        ctx->queue[w].end = nbChunks*(w+1)/ctx->nbThreads;
+    }
+}
+
+static void computeChunks(parallelContext* ctx, int victim){
+    // Postcondition: all chunks of the queue of victim are computed (by this thread or by others)
+    chunkQueue* q = &ctx->queue[victim];
+    while (true){
+        size_t c = atomic_fetch_add_explicit(&q->next, 1, memory_order_relaxed);
+        if (c >= q->end) return;
+        size_t first = c*ctx->chunkSize;
+        size_t last = first + ctx->chunkSize;
+        if (last > ctx->nbSets) last = ctx->nbSets;
+        hkComputeRange(ctx->t, ctx->cost, ctx->k, first, last);
+    }
+}
+
+static void* workerLoop(void* arg){
+    worker* w = (worker*) arg;
+    parallelContext* ctx = w->ctx;
+    pthread_mutex_lock(&ctx->start);
+    pthread_mutex_unlock(&ctx->start);
+    pinThread(ctx, w->id);
+    for (int k=1; k<ctx->n; k++){
+        if (w->id == 0){
+            dealChunks(ctx, k);
+            ctx->layerStart = wallTime();
+        }
+        pthread_barrier_wait(&ctx->barrier);
+        // own chunks first, then steal from the other threads
+        for (int v=0; v<ctx->nbThreads; v++)
+            computeChunks(ctx, (w->id + v) % ctx->nbThreads);
+        pthread_barrier_wait(&ctx->barrier);
+        if (w->id == 0 && ctx->layerTime != NULL) ctx->layerTime[k] = wallTime() - ctx->layerStart;
+        if (w->id == 0) INSTR_LAYER(k, ctx->layerStart);
+    }
+    if (w->id > 0) INSTR_MERGE();
+    return NULL;
+}
+
+static void touchRange(int* cells, size_t first, size_t last){
+    // Postcondition: one int of each page of cells[first..last-1] is written, with 0 (its value in an untouched page)
+    size_t stride = (size_t)sysconf(_SC_PAGESIZE) / sizeof(int);
+    for (size_t c=first; c<last; c+=stride) cells[c] = 0;
+    if (last > first) cells[last-1] = 0;
+}
+
+static void* touchLoop(void* arg){
+    // Postcondition: the pages of the cells that worker w->id computes first are written by this thread, pinned as that worker
+    worker* w = (worker*) arg;
+    hkTable* t = w->ctx->t;
+    int nbThreads = w->ctx->nbThreads;
+    pinThread(w->ctx, w->id);
+    if (t->layout == HK_LAYOUT_SMAJOR){
+        // the subsets of a layer are spread over the whole table: split it evenly instead
+        size_t first = t->nbCells*w->id/nbThreads, last = t->nbCells*(w->id+1)/nbThreads;
+        touchRange(t->dp, first, last);
+        touchRange(t->succ, first, last);
+        return NULL;
+    }
+    for (int k=1; k<t->n; k++){
+        // same ranges as dealChunks
+        size_t nbSets = binom[t->n-1][k];
+        size_t chunkSize = chunkSizeOf(nbSets, nbThreads);
+        size_t nbChunks = (nbSets + chunkSize - 1) / chunkSize;
+        size_t first = nbChunks*w->id/nbThreads*chunkSize;
+        size_t last = nbChunks*(w->id+1)/nbThreads*chunkSize;
+        if (last > nbSets) last = nbSets;
+        if (first >= last) continue;
+        size_t cell = t->layerOffset[k] + first*t->n;
+        touchRange(t->dp, cell, cell + (last - first)*t->n);
+        touchRange(t->succ, cell, cell + (last - first)*t->n);
+    }
+    return NULL;
+}
+
+/**
+ * Map the pages of t before heldKarp_parallel with the same number of threads:
+ * each page is written first by a thread pinned to the CPU of the worker that computes its cells
+ * (NUMA first-touch placement). Only one int per page is written: the kernel zero-fills the rest.
+ * Precondition: the cells of t are not in use (they are overwritten with 0)
+ */
+void hkFirstTouch(hkTable* t, int nbThreads){
+    if (nbThreads < 1) nbThreads = 1;
+    parallelContext ctx = {.t = t, .nbThreads = nbThreads};
+    initPinning(&ctx);
+    worker workers[nbThreads];
+    pthread_t threads[nbThreads];
+    int launched = 1;
+    for (int w=0; w<nbThreads; w++) workers[w] = (worker){.ctx = &ctx, .id = w};
+    while (launched < nbThreads && pthread_create(&threads[launched], NULL, touchLoop, &workers[launched]) == 0) launched++;
+    for (int w=launched; w<nbThreads; w++) touchLoop(&workers[w]); // threads that cannot be started
+    touchLoop(&workers[0]);
+    for (int w=1; w<launched; w++) pthread_join(threads[w], NULL);
+    endPinning(&ctx);
+}
+
+/**
+ * Held-Karp algorithm computed by nbThreads threads
+ * Returns the same length and stores the same kind of tour as heldKarp_table, or -1 if there is not enough memory.
+ * If layerTime is not NULL, layerTime[k] is set to the wall-clock time spent on layer k.
+ * If some threads cannot be started, the layers are computed by those that could.
+ */
+int heldKarp_parallel(int n, const costProvider* cost, hkTable* t, int nbThreads, double* layerTime){
+    if (nbThreads < 1) nbThreads = 1;
+    parallelContext ctx;
+    ctx.t = t;
+    ctx.cost = cost;
+    ctx.n = n;
+    ctx.layerTime = layerTime;
+    ctx.queue = (chunkQueue*) aligned_alloc(64, nbThreads*sizeof(chunkQueue));
+    if (ctx.queue == NULL) return -1;
+    initPinning(&ctx);
+    worker workers[nbThreads];
+    pthread_t threads[nbThreads];
+
+    INSTR_START(tInit);
+    hkInitBase(t, cost);
+    INSTR_PHASE(PHASE_INIT, tInit);
+    INSTR_START(tSweep);
+    INSTR_PERF_BEGIN();
+    for (int w=0; w<nbThreads; w++) workers[w] = (worker){.ctx = &ctx, .id = w};
+    pthread_mutex_init(&ctx.start, NULL);
+    pthread_mutex_lock(&ctx.start);
+    int launched = 1;
+    while (launched < nbThreads && pthread_create(&threads[launched], NULL, workerLoop, &workers[launched]) == 0) launched++;
+    ctx.nbThreads = launched;
+    pthread_barrier_init(&ctx.barrier, NULL, launched);
+    pthread_mutex_unlock(&ctx.start);
+    workerLoop(&workers[0]); // the calling thread is worker 0
+    for (int w=1; w<launched; w++) pthread_join(threads[w], NULL);
+    INSTR_PERF_END();
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+
+    endPinning(&ctx);
+    pthread_barrier_destroy(&ctx.barrier);
+    pthread_mutex_destroy(&ctx.start);
+    free(ctx.queue);
+    return hkCloseTour(t, cost);
+}
@@ -0,0 +1,131 @@
+/*
+ Vectorised kernel for the bottom-up Held-Karp algorithm
+
+ With the S-major layout, the n cells of a subset S form one row dp[S][0..n-1].
+ For each j in S, the value dp(j, S\{j}) is read once and added to the column j of the
+ cost matrix (cost of (i,j) for all i, stored contiguously in costT), and the row of S is
+ the element-wise min (and argmin) of these k vectors. Lanes of vertices i in S are
+ computed too and thrown away, which is cheaper than masking them.
+ The vector path uses AVX-512 or AVX2 when the compiler targets them (-march=native),
+ and falls back to the scalar loop otherwise.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "hkSimd.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX512F__)
+#define LANES 16
+#elif defined(__AVX2__)
+#define LANES 8
+#else
+#define LANES 1
+#endif
+
+#define PAD 32 // row length of costT and of the local rows: n <= 32, and a multiple of LANES
+
+const char* hkVectorIsa(void){
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
+
+static void minRowScalar(set out, const int* costT, int k, const int* js, const int* val, int* best, int* arg){
+    // Postcondition: best[i] and arg[i] are computed for the vertices i of out only
+    int i;
+    forEachElement(i, out){
+        int b = INT_MAX, a = -1;
+        for (int m=0; m<k; m++){
+            int alt = costT[js[m]*PAD + i] + val[m];
+            if (alt < b){
+                b = alt;
+                a = js[m];
+            }
+        }
+        best[i] = b;
+        arg[i] = a;
+    }
+}
+
+static void minRowVector(int n, const int* costT, int k, const int* js, const int* val, int* best, int* arg){
+#if defined(__AVX512F__)
+    for (int i0=0; i0<n; i0+=LANES){
+        __m512i b = _mm512_set1_epi32(INT_MAX);
+        __m512i a = _mm512_set1_epi32(-1);
+        for (int m=0; m<k; m++){
+            __m512i alt = _mm512_add_epi32(_mm512_loadu_si512((const void*)(costT + js[m]*PAD + i0)), _mm512_set1_epi32(val[m]));
+            __mmask16 better = _mm512_cmplt_epi32_mask(alt, b);
+            b = _mm512_min_epi32(b, alt);
+            a = _mm512_mask_mov_epi32(a, better, _mm512_set1_epi32(js[m]));
+        }
+        _mm512_storeu_si512((void*)(best + i0), b);
+        _mm512_storeu_si512((void*)(arg + i0), a);
+    }
+#elif defined(__AVX2__)
+    for (int i0=0; i0<n; i0+=LANES){
+        __m256i b = _mm256_set1_epi32(INT_MAX);
+        __m256i a = _mm256_set1_epi32(-1);
+        for (int m=0; m<k; m++){
+            __m256i alt = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(costT + js[m]*PAD + i0)), _mm256_set1_epi32(val[m]));
+            __m256i better = _mm256_cmpgt_epi32(b, alt);
+            b = _mm256_min_epi32(b, alt);
+            a = _mm256_blendv_epi8(a, _mm256_set1_epi32(js[m]), better);
+        }
+        _mm256_storeu_si256((__m256i*)(best + i0), b);
+        _mm256_storeu_si256((__m256i*)(arg + i0), a);
+    }
+#else
+    minRowScalar(createSet(n), costT, k, js, val, best, arg);
+#endif
+}
+
+/**
+ * Held-Karp algorithm on an S-major table, with the min-reduction of a whole row done at once
+ * Precondition: t->layout == HK_LAYOUT_SMAJOR
+ * Return the length of the smallest tour, or -1 if there is not enough memory
+ */
+int heldKarp_simd(int n, const costProvider* cost, hkTable* t, hkKernel kernel){
+    int* costT = (int*) aligned_alloc(64, PAD*PAD*sizeof(int)); // costT[j*PAD + i] = cost[i][j]
+    if (costT == NULL) return -1;
+    for (int j=0; j<PAD; j++)
+        for (int i=0; i<PAD; i++)
+            costT[j*PAD + i] = (i < n && j < n) ? costOf(cost, i, j) : 0;
+
+    int* dp = t->dp;
+    int* succ = t->succ;
+    hkInitBase(t, cost);
+
+    set ALL = createSet(n);
+    int js[32], val[32];
+    _Alignas(64) int best[PAD] = {0};
+    _Alignas(64) int arg[PAD] = {0};
+    for (int k=1; k<n; k++){
+        set S = createSet(k+1); // first subset of size k
+        size_t nbSets = binom[n-1][k];
+        for (size_t r=0; r<nbSets; r++, S = nextSetOfSameSize(S)){
+            size_t base = setIndex(S)*n;
+            int j, m = 0;
+            forEachElement(j, S){
+                js[m] = j;
+                val[m] = dp[setIndex(removeElement(S,j))*n + j];
+                m++;
+            }
+            if (kernel == HK_KERNEL_VECTOR) minRowVector(n, costT, k, js, val, best, arg);
+            else minRowScalar(ALL & ~S, costT, k, js, val, best, arg);
+            // the cell of the depot (0) is only used for the full set, by hkCloseTour
+            memcpy(dp + base + 1, best + 1, (n-1)*sizeof(int));
+            memcpy(succ + base + 1, arg + 1, (n-1)*sizeof(int));
+        }
+    }
+    free(costT);
+    return hkCloseTour(t, cost);
+}
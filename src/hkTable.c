@@ -0,0 +1,232 @@
+/*
+ Contiguous DP table engine for the bottom-up Held-Karp algorithm
+
+ heldKarp_iter stores dp[i][S] in n separate rows of 2^(n-1) integers, so computing
+ the cells of a subset S reads dp[j][S\{j}] in n different rows. The engine below
+ allocates dp and succ as two single blocks in which the n cells of a subset are
+ contiguous, and walks the subsets layer by layer (by increasing size).
+ The blocks come from an arena of transparent huge pages: they need no fill loop, and their
+ pages are only mapped (2 MB at a time) by the first thread that writes them.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "hkTable.h"
+#include "timer.h"
+#include "instrument.h"
+
+uint64_t binom[33][33];
+
+void initBinom(void){
+    // Postcondition: binom[a][b] = C(a,b) for all 0 <= b <= a <= 32
+    for (int a=0; a<33; a++){
+        binom[a][0] = 1;
+        for (int b=1; b<33; b++)
+            binom[a][b] = (a == 0) ? 0 : binom[a-1][b-1] + binom[a-1][b];
+    }
+}
+
+/**
+ * Rank of a set among the sets of the same size, in colex order
+ * (combinatorial number system): if the elements of s are stored on bits
+ * b_0 < b_1 < ... < b_{k-1}, then rank(s) = sum_t C(b_t, t+1).
+ * Enumerating the sets of size k with nextSetOfSameSize gives ranks 0, 1, 2, ...
+ */
+size_t rankSet(set s){
+    size_t rank = 0;
+    int e, t = 1;
+    forEachElement(e, s) rank += binom[e-1][t++];
+    return rank;
+}
+
+set unrankSet(size_t rank, int k){
+    // Precondition: rank < C(32,k)
+    // Postcondition: return the set s of size k such that rankSet(s) = rank
+    set s = 0;
+    for (int t=k; t>=1; t--){
+        int b = t - 1;
+        while (binom[b+1][t] <= rank) b++;
+        rank -= binom[b][t];
+        s = addElement(s, b+1);
+    }
+    return s;
+}
+
+hkTable* hkTableCreate(int n, hkLayout layout){
+    // Precondition: 2 <= n <= 32
+    // Postcondition: return a table for n vertices, or NULL if there is not enough memory
+    INSTR_START(start);
+    hkTable* t = (hkTable*) malloc(sizeof(hkTable));
+    if (t == NULL) return NULL;
+    t->layout = layout;
+    t->nbCells = (size_t)n << (n-1);
+    t->storage = arenaCreatePages(2*(t->nbCells*sizeof(int) + 64) + 4096, ARENA_PAGES_TRANSPARENT); // dp and succ in one block
+    t->dp = (t->storage == NULL) ? NULL : (int*) arenaAlloc(t->storage, t->nbCells*sizeof(int));
+    t->succ = (t->dp == NULL) ? NULL : (int*) arenaAlloc(t->storage, t->nbCells*sizeof(int));
+    if (t->succ == NULL){
+        hkTableFree(t);
+        return NULL;
+    }
+    hkTableSetSize(t, n);
+    INSTR_PHASE(PHASE_ALLOC, start);
+    return t;
+}
+
+void hkTableSetSize(hkTable* t, int n){
+    // Precondition: 2 <= n, and the table was created for at least n vertices
+    // Postcondition: t is used for n vertices, in the first n * 2^(n-1) cells of its blocks
+    t->n = n;
+    t->nbCells = (size_t)n << (n-1);
+    // layer k contains the C(n-1,k) subsets of size k
+    t->layerOffset[0] = 0;
+    for (int k=0; k<n; k++)
+        t->layerOffset[k+1] = t->layerOffset[k] + binom[n-1][k]*n;
+}
+
+void hkTableFree(hkTable* t){
+    if (t == NULL) return;
+    arenaFree(t->storage);
+    free(t);
+}
+
+size_t hkCell(const hkTable* t, set s, int i){
+    // Postcondition: return the index of cell (i,s) in t->dp and t->succ
+    if (t->layout == HK_LAYOUT_SMAJOR) return setIndex(s)*t->n + i;
+    return t->layerOffset[setSize(s)] + rankSet(s)*t->n + i;
+}
+
+const char* hkLayoutName(hkLayout layout){
+    switch (layout){
+        case HK_LAYOUT_SMAJOR: return "S-major";
+        case HK_LAYOUT_LAYERED: return "layered";
+    }
+    return "?";
+}
+
+void hkInitBase(hkTable* t, const costProvider* cost){
+    // Postcondition: the cells of the empty set are initialised (go back to the depot (0) from i)
+    for (int i=1; i<t->n; i++){
+        t->dp[i] = costOf(cost, i, 0);
+        t->succ[i] = 0;
+    }
+}
+
+/**
+ * Compute the cells of the subsets of size k whose rank is in [first,last)
+ * Same recurrence as heldKarp_iter, but:
+ * - the k values dp(j, S\{j}) are gathered once per subset S and reused for the n-1-k vertices i not in S
+ * - for the layered layout, the ranks of the k subsets S\{j} are derived from the rank of S in O(k)
+ * Precondition: all cells of layer k-1 are computed
+ * Ranges of a same layer write disjoint cells and may be computed concurrently.
+ */
+void hkComputeRange(hkTable* t, const costProvider* cost, int k, size_t first, size_t last){
+    int n = t->n;
+    int* dp = t->dp;
+    int* succ = t->succ;
+    int bit[32];      // bit[m] = position of the m-th element of S
+    size_t sub[32];   // sub[m] = index of the first cell of S \ {bit[m]+1}
+    int val[32];      // val[m] = dp(bit[m]+1, S \ {bit[m]+1})
+    if (first >= last) return;
+    INSTR_COUNT(COUNTER_STATES, (last - first)*(uint64_t)(n-1-k));
+    set S = unrankSet(first, k);
+    set ALL = createSet(n);
+    for (size_t r=first; r<last; r++, S = nextSetOfSameSize(S)){
+        int e, m = 0;
+        forEachElement(e, S) bit[m++] = e - 1;
+        size_t base;
+        if (t->layout == HK_LAYOUT_SMAJOR){
+            base = setIndex(S)*n;
+            for (int m=0; m<k; m++) sub[m] = base - ((size_t)1 << bit[m])*n;
+        } else {
+            // rank(S \ {bit[m]+1}) = sum_{t<m} C(bit[t],t+1) + sum_{t>m} C(bit[t],t)
+            base = t->layerOffset[k] + r*n;
+            size_t prefix = 0;
+            for (int m=0; m<k; m++){
+                sub[m] = prefix;
+                prefix += binom[bit[m]][m+1];
+            }
+            size_t suffix = 0;
+            for (int m=k-1; m>=0; m--){
+                sub[m] = t->layerOffset[k-1] + (sub[m] + suffix)*n;
+                suffix += binom[bit[m]][m];
+            }
+        }
+        for (int m=0; m<k; m++) val[m] = dp[sub[m] + bit[m] + 1];
+
+        int i;
+        forEachElement(i, ALL & ~S){ // i must not be in S
+            int best = INT_MAX;
+            int bestj = -1;
+            for (int m=0; m<k; m++){
+                int alt = costOf(cost, i, bit[m]+1) + val[m];
+                if (alt < best){
+                    best = alt;
+                    bestj = bit[m]+1;
+                }
+            }
+            dp[base+i] = best;
+            succ[base+i] = bestj;
+        }
+    }
+}
+
+int hkCloseTour(hkTable* t, const costProvider* cost){
+    // Precondition: all layers are computed
+    // Postcondition: return the length of the smallest tour, and store its first vertex in cell (0, {1,...,n-1})
+    int n = t->n;
+    set ALL = createSet(n);
+    size_t last = hkCell(t, ALL, 0);
+    int best = INT_MAX;
+    int bestj = -1;
+    for (int j=1; j<n; j++){
+        int alt = costOf(cost, 0, j) + t->dp[hkCell(t, removeElement(ALL,j), j)];
+        if (alt < best){
+            best = alt;
+            bestj = j;
+        }
+    }
+    t->dp[last] = best;
+    t->succ[last] = bestj;
+    return best;
+}
+
+/**
+ * Held-Karp algorithm on a contiguous table
+ * Subsets are enumerated layer by layer, so that all predecessors of a subset are already computed.
+ * If layerTime is not NULL, layerTime[k] is set to the wall-clock time spent on layer k.
+ */
+int heldKarp_table(int n, const costProvider* cost, hkTable* t, double* layerTime){
+    INSTR_START(tInit);
+    hkInitBase(t, cost);
+    INSTR_PHASE(PHASE_INIT, tInit);
+    INSTR_START(tSweep);
+    INSTR_PERF_BEGIN();
+    for (int k=1; k<n; k++){ // all subsets of size k
+        double start = wallTime();
+        hkComputeRange(t, cost, k, 0, binom[n-1][k]);
+        if (layerTime != NULL) layerTime[k] = wallTime() - start;
+        INSTR_LAYER(k, start);
+    }
+    INSTR_PERF_END();
+    INSTR_PHASE(PHASE_SWEEP, tSweep);
+    return hkCloseTour(t, cost);
+}
+
+void printTour_table(const hkTable* t){
+    // Postcondition: print the tour stored in t, starting from the depot (0)
+    INSTR_START(start);
+    set S = createSet(t->n);
+    int i = 0;
+    printf("Circuit : 0");
+    for (int k=0; k<t->n-1; k++){
+        int j = t->succ[hkCell(t, S, i)];
+        if (j <= 0){ printf(" ?"); break; }
+        printf(" %d", j);
+        S = removeElement(S, j);
+        i = j;
+    }
+    printf(" 0\n");
+    INSTR_PHASE(PHASE_RECONSTRUCT, start);
+}
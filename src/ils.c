@@ -0,0 +1,136 @@
+/*
+ Iterated local search with double-bridge kicks and a wall-clock budget
+
+ Each iteration applies a double bridge to the current tour: A B C D becomes A C B D, which removes
+ 3 edges and adds 3 others that no sequence of 2-opt moves easily undoes. B and C are short segments
+ (at most SEGMENT vertices each) from a random vertex, so that the kick is local and the change of
+ length is computed from the 6 edges. The local search then only starts from the end points of these
+ edges: the rest of the tour is still locally optimal. Its state (positions or two-level list, queue)
+ is kept from one iteration to the next, and a rejected trial is undone by replaying the log of its
+ 2-opt moves backwards, so that an iteration costs O(moves) rather than O(n).
+ With a Balas-Simonetti width, the tour is then improved in that neighbourhood, whose size is exponential
+ in the width, in time linear in n: this step is much slower than the local search, but escapes more of its
+ local optima.
+ The search runs until the time limit (or the maximum number of iterations) is reached, and returns
+ the best tour found.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "ils.h"
+#include "rng.h"
+#include "timer.h"
+
+#define SEGMENT 50 // maximum length of the segments exchanged by a double bridge
+
+static int doubleBridge(lsSearch* s, const costProvider* cost, rng* r, int* kicked){
+    // Precondition: n >= 8
+    // Postcondition: the tour A B C D of s is replaced by A C B D, where B and C are non empty and start at a random vertex,
+    //                kicked[0..5] are the end points of the removed edges,
+    //                and the change of length of the tour is returned
+    int n = s->n;
+    int len = (n-2)/3 < SEGMENT ? (n-2)/3 : SEGMENT;
+    int lb = 1 + rngNext(r, len), lc = 1 + rngNext(r, len);
+    int a = rngNext(r, n), b1 = lsSearchNext(s, a), b2 = b1;
+    for (int k=1; k<lb; k++) b2 = lsSearchNext(s, b2);
+    int c1 = lsSearchNext(s, b2), c2 = c1;
+    for (int k=1; k<lc; k++) c2 = lsSearchNext(s, c2);
+    int d = lsSearchNext(s, c2);
+    int delta = costOf(cost, a, c1) + costOf(cost, c2, b1) + costOf(cost, b2, d) - costOf(cost, a, b1) - costOf(cost, b2, c1) - costOf(cost, c2, d);
+    lsSearchExchange(s, a, b1, b2, c1, c2, d);
+    kicked[0] = a; kicked[1] = b1; kicked[2] = b2;
+    kicked[3] = c1; kicked[4] = c2; kicked[5] = d;
+    return delta;
+}
+
+static bool accept(const ilsParams* params, int length, int current, int best){
+    switch (params->accept){
+        case ILS_ACCEPT_WALK:
+            return true;
+        case ILS_ACCEPT_THRESHOLD:
+            return length <= current || length < best*(1 + params->threshold/100);
+        default:
+            return length <= current;
+    }
+}
+
+/**
+ * Iterated local search
+ * Input: sol[0..n-1] contains a permutation of [0,n-1], and total = length of the tour associated with sol
+ * Output: sol[0..n-1] is the best tour found within the budget of params
+ * Return its length, or -1 if there is not enough memory
+ */
+int iteratedLS(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves,
+               const ilsParams* params, ilsStats* stats){
+    double start = wallTime();
+    ilsStats local;
+    if (stats == NULL) stats = &local;
+    *stats = (ilsStats){0};
+    int best = neighbourLS(n, sol, total, cost, c, moves, NULL);
+    if (best < 0) return -1;
+    if (params->trace != NULL) fprintf(params->trace, "%.6f,%d\n", wallTime() - start, best);
+    outputTour(params->out, sol, best);
+    if (n < 8) return best;
+
+    // the current tour is searched in place, and the moves of a rejected trial are undone from the log of the search;
+    // the Balas-Simonetti step rewrites the whole tour, so with it the current tour is saved before each trial
+    int* cur = (int*) malloc(n*sizeof(int));
+    int* saved = (params->bsWidth > 0) ? (int*) malloc(n*sizeof(int)) : NULL;
+    int kicks = params->kicksPerIteration > 0 ? params->kicksPerIteration : 1;
+    int* kicked = (int*) malloc(6*kicks*sizeof(int));
+    bsTable* bs = (params->bsWidth > 0) ? bsCreate(n, params->bsWidth < n ? params->bsWidth : n-1) : NULL;
+    if (cur != NULL) memcpy(cur, sol, n*sizeof(int));
+    // the reversals of a search from the kicked vertices are short: the list only pays off when it is forced
+    lsSearch* s = (cur != NULL) ? lsSearchCreate(n, cur, lsTourChoice == LS_TOUR_LIST) : NULL;
+    if (s == NULL || kicked == NULL || (params->bsWidth > 0 && (bs == NULL || saved == NULL))){
+        lsSearchFree(s);
+        free(cur);
+        free(saved);
+        free(kicked);
+        bsFree(bs);
+        return -1;
+    }
+    int curLength = best;
+    rng r;
+    rngInit(&r, params->seed, 0);
+    while ((params->maxIterations == 0 || stats->iterations < params->maxIterations) && wallTime() - start < params->timeLimit){
+        stats->iterations++;
+        if (bs != NULL) memcpy(saved, cur, n*sizeof(int)); // cur is up to date after the reload of the previous trial
+        lsSearchMark(s);
+        int length = curLength;
+        for (int k=0; k<kicks; k++) length += doubleBridge(s, cost, &r, kicked + 6*k);
+        length = lsSearchRun(s, length, cost, c, moves, kicked, 6*kicks, NULL);
+        if (length < 0) break;
+        if (bs != NULL){
+            lsSearchSync(s);
+            length = balasSimonettiLS(bs, cur, length, cost, NULL);
+            lsSearchReload(s);
+        }
+        if (length < best){
+            best = length;
+            lsSearchSync(s);
+            memcpy(sol, cur, n*sizeof(int));
+            stats->improvements++;
+            if (params->trace != NULL) fprintf(params->trace, "%.6f,%d\n", wallTime() - start, best);
+            outputTour(params->out, sol, best);
+        }
+        if (accept(params, length, curLength, best)){
+            curLength = length;
+            stats->accepted++;
+        } else if (bs != NULL){
+            memcpy(cur, saved, n*sizeof(int));
+            lsSearchReload(s);
+        } else {
+            lsSearchUndo(s);
+        }
+        if (s->failed) break;
+    }
+    lsSearchFree(s);
+    free(cur);
+    free(saved);
+    free(kicked);
+    bsFree(bs);
+    stats->seconds = wallTime() - start;
+    return best;
+}
@@ -0,0 +1,163 @@
+/*
+ Instrumentation of the hot paths (see instrument.h)
+
+ The hardware counters are opened with perf_event_open around each DP sweep, for the calling
+ thread and the threads it creates during the sweep (inherit), in user space only, so that
+ they are available with the default perf_event_paranoid setting. When the kernel or the
+ virtual machine does not provide them, the report says so and the rest is unchanged.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "instrument.h"
+
+_Thread_local instrRecord instrLocal;
+static instrRecord instrTotal;
+#if INSTRUMENT
+static pthread_mutex_t instrLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static const char* instrReportPath = NULL;
+
+static const char* phaseNames[NB_PHASES] = {"alloc", "init", "sweep", "reconstruct", "descent"};
+static const char* counterNames[NB_COUNTERS] = {"memo_hits", "memo_misses", "states", "moves_evaluated"};
+static const char* perfNames[NB_PERF_EVENTS] = {"cycles", "instructions", "llc_misses", "dtlb_misses"};
+
+static int perfFds[NB_PERF_EVENTS] = {-1, -1, -1, -1};
+static uint64_t perfTotal[NB_PERF_EVENTS];
+static uint64_t perfSweeps = 0;   // number of sweeps measured
+static int perfError = 0;         // errno of the first counter that could not be opened
+
+/**
+ * Add the record of the calling thread to the total of the process, and reset it
+ * Each thread that runs instrumented code calls it before it ends.
+ */
+void instrumentMerge(void){
+#if INSTRUMENT
+    pthread_mutex_lock(&instrLock);
+    for (int p=0; p<NB_PHASES; p++){
+        instrTotal.phaseTime[p] += instrLocal.phaseTime[p];
+        instrTotal.phaseCalls[p] += instrLocal.phaseCalls[p];
+    }
+    for (int k=0; k<INSTR_MAX_LAYERS; k++) instrTotal.layerTime[k] += instrLocal.layerTime[k];
+    for (int c=0; c<NB_COUNTERS; c++) instrTotal.counters[c] += instrLocal.counters[c];
+    pthread_mutex_unlock(&instrLock);
+    memset(&instrLocal, 0, sizeof(instrLocal));
+#endif
+}
+
+static int perfOpen(uint32_t type, uint64_t config){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;          // count the worker threads too
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define CACHE_READ_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/**
+ * Start the hardware counters (the previous perfBegin must have been closed by perfEnd)
+ */
+void perfBegin(void){
+    if (perfError != 0) return; // not available: do not try again at each sweep
+    perfFds[PERF_CYCLES] = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    perfFds[PERF_INSTRUCTIONS] = perfOpen(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    perfFds[PERF_LLC_MISSES] = perfOpen(PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL));
+    perfFds[PERF_DTLB_MISSES] = perfOpen(PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB));
+    for (int e=0; e<NB_PERF_EVENTS; e++){
+        if (perfFds[e] < 0 && perfError == 0) perfError = errno;
+    }
+    if (perfError != 0){
+        for (int e=0; e<NB_PERF_EVENTS; e++){
+            if (perfFds[e] >= 0) close(perfFds[e]);
+            perfFds[e] = -1;
+        }
+    }
+}
+
+/**
+ * Stop the hardware counters started by perfBegin, and add their values to the totals
+ * Precondition: the threads created since perfBegin have ended
+ */
+void perfEnd(void){
+    if (perfFds[0] < 0) return;
+    for (int e=0; e<NB_PERF_EVENTS; e++){
+        uint64_t value;
+        if (read(perfFds[e], &value, sizeof(value)) == sizeof(value)) perfTotal[e] += value;
+        close(perfFds[e]);
+        perfFds[e] = -1;
+    }
+    perfSweeps++;
+}
+
+/**
+ * Write the report of the instrumentation, as a JSON object
+ * The derived ratios say whether the sweeps were memory-bound (many LLC and dTLB misses per state,
+ * low instructions per cycle) or compute-bound.
+ */
+void instrumentReport(FILE* f){
+    instrumentMerge();
+    fprintf(f, "{\n  \"instrument\": %d,\n  \"phases\": {", INSTRUMENT);
+    for (int p=0; p<NB_PHASES; p++)
+        fprintf(f, "%s\n    \"%s\": {\"seconds\": %.6f, \"calls\": %lu}", p == 0 ? "" : ",", phaseNames[p],
+                instrTotal.phaseTime[p], (unsigned long)instrTotal.phaseCalls[p]);
+    fprintf(f, "\n  },\n  \"layers_seconds\": [");
+    int last = INSTR_MAX_LAYERS - 1;
+    while (last > 0 && instrTotal.layerTime[last] == 0) last--;
+    for (int k=1; k<=last; k++) fprintf(f, "%s%.6f", k == 1 ? "" : ", ", instrTotal.layerTime[k]);
+    fprintf(f, "],\n  \"counters\": {");
+    for (int c=0; c<NB_COUNTERS; c++)
+        fprintf(f, "%s\"%s\": %lu", c == 0 ? "" : ", ", counterNames[c], (unsigned long)instrTotal.counters[c]);
+    uint64_t lookups = instrTotal.counters[COUNTER_MEMO_HIT] + instrTotal.counters[COUNTER_MEMO_MISS];
+    fprintf(f, "},\n  \"memo_hit_rate\": %.4f,\n  \"perf\": ", lookups > 0 ? (double)instrTotal.counters[COUNTER_MEMO_HIT]/lookups : 0);
+    if (INSTRUMENT < 2) fprintf(f, "{\"available\": false, \"reason\": \"compiled with INSTRUMENT=%d\"}", INSTRUMENT);
+    else if (perfSweeps == 0)
+        fprintf(f, "{\"available\": false, \"reason\": \"%s%s\"}", perfError != 0 ? "perf_event_open: " : "",
+                perfError != 0 ? strerror(perfError) : "no sweep measured");
+    else {
+        fprintf(f, "{\"available\": true, \"sweeps\": %lu", (unsigned long)perfSweeps);
+        for (int e=0; e<NB_PERF_EVENTS; e++) fprintf(f, ", \"%s\": %lu", perfNames[e], (unsigned long)perfTotal[e]);
+        // states of the bottom-up solvers, or memoised lookups for computeD_memo
+        double states = (instrTotal.counters[COUNTER_STATES] > 0) ? instrTotal.counters[COUNTER_STATES] : lookups;
+        fprintf(f, ", \"ipc\": %.3f", perfTotal[PERF_CYCLES] > 0 ? (double)perfTotal[PERF_INSTRUCTIONS]/perfTotal[PERF_CYCLES] : 0);
+        fprintf(f, ", \"llc_misses_per_kinstr\": %.3f",
+                perfTotal[PERF_INSTRUCTIONS] > 0 ? 1e3*perfTotal[PERF_LLC_MISSES]/perfTotal[PERF_INSTRUCTIONS] : 0);
+        fprintf(f, ", \"llc_misses_per_state\": %.4f, \"dtlb_misses_per_state\": %.4f}",
+                states > 0 ? perfTotal[PERF_LLC_MISSES]/states : 0, states > 0 ? perfTotal[PERF_DTLB_MISSES]/states : 0);
+    }
+    fprintf(f, "\n}\n");
+}
+
+static void writeReport(void){
+    FILE* f = (instrReportPath != NULL) ? fopen(instrReportPath, "w") : stderr;
+    if (f == NULL){
+        fprintf(stderr, "Cannot create the instrumentation report %s.\n", instrReportPath);
+        return;
+    }
+    instrumentReport(f);
+    if (f != stderr) fclose(f);
+}
+
+/**
+ * Write the report in file reportPath (stderr if NULL) when the program exits
+ * Does nothing if the instrumentation is compiled out.
+ */
+void instrumentInit(const char* reportPath){
+#if INSTRUMENT
+    instrReportPath = reportPath;
+    atexit(writeReport);
+#else
+    (void)writeReport;
+    if (reportPath != NULL) fprintf(stderr, "No instrumentation report: compile with INSTRUMENT=1 or 2.\n");
+#endif
+}
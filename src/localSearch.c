@@ -0,0 +1,236 @@
+/*
+ Local search on tours represented by a permutation sol[0..n-1] of the vertices
+ Copyright (C) 2023 Christine Solnon
+ Ce programme est un logiciel libre ; vous pouvez le redistribuer et/ou le modifier au titre des clauses de la Licence Publique Générale GNU, telle que publiée par la Free Software Foundation. Ce programme est distribué dans l'espoir qu'il sera utile, mais SANS AUCUNE GARANTIE ; sans même une garantie implicite de COMMERCIABILITE ou DE CONFORMITE A UNE UTILISATION PARTICULIERE. Voir la Licence Publique Générale GNU pour plus de détails.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "localSearch.h"
+#include "instrument.h"
+
+/**
+ * Check if the edges (node0->node1) and (nodeLast->nodeNew) "cross"
+ */
+bool isCrossing(
+    int node0, // v_i
+    int node1, // v{i+1}
+    int nodeLast, // v_j
+    int nodeNew, // v{j+1}
+    const costProvider* cost
+) {
+    /* check each edge before the last one
+
+    Example:
+    ╎     ╎
+    Ⓝ◁---①
+    ╎◸   ◹╎
+    ╎ ╲ ╱ ╎
+    ╎  ╳  ╎
+    ╎ ╱ ╲ ╎
+    ╎╱   ╲╎
+    ⓪---▷Ⓛ
+    ╎     ╎
+    We check that any edge (⓪->① + Ⓛ->Ⓝ) <= (⓪->Ⓛ + ①->Ⓝ)
+    */
+    // cost Ⓛ->Ⓝ
+    int costLastToNew = costOf(cost, nodeLast, nodeNew);
+    // cost ⓪->①
+    int cost0to1 = costOf(cost, node0, node1);
+    // cost ⓪->Ⓛ
+    int cost0toLast = costOf(cost, node0, nodeLast);
+    // cost ①->Ⓝ
+    int cost1toNew = costOf(cost, node1, nodeNew);
+    if (
+        (cost0toLast + cost1toNew) // cost ⓪->Ⓛ + ①->Ⓝ
+        < (cost0to1 + costLastToNew) // cost ⓪->① + Ⓛ->Ⓝ
+    ) {
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool is_2opt(int v_i0, int v_i1, int v_j0, int v_j1, const costProvider* cost){
+    int oldCost = costOf(cost, v_i0, v_i1) + costOf(cost, v_j0, v_j1);
+    int newCost = costOf(cost, v_i0, v_j0) + costOf(cost, v_i1, v_j1);
+    if (newCost < oldCost) {
+        return true; // the two edges cross
+    } else {
+        return false; // the two edges do not cross
+    }
+}
+
+void swap(int* sol, int i, int j){
+    // input: sol[0..n-1] = permutation of [0,n-1]; i,j = indices of two vertices in sol
+    // side effect: swap the two vertices in sol
+    int tmp = sol[i];
+    sol[i] = sol[j];
+    sol[j] = tmp;
+}
+
+bool while_procedure(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated){
+    // Postcondition: the first crossing found is removed, and the number of 2-opt moves evaluated is added to *nbEvaluated (if not NULL)
+    int v_i0 = 0;
+    int v_i1 = 0;
+    int v_j0 = 0;
+    int v_j1 = 0;
+    uint64_t evaluated = 0;
+    for (int i=0; i<n-1; i++) {
+        evaluated += (n-i-2 > 0) ? n-i-2 : 0;
+        for (int j=i+2; j<n; j++) {
+            v_i0 = sol[i];
+            v_i1 = sol[i+1];
+            v_j0 = sol[j];
+            if (j == n-1) 
+                v_j1 = sol[0];
+            else
+                v_j1 = sol[j+1];
+            
+            //if (is_2opt(v_i0, v_i1, v_j0, v_j1, cost)) {
+            if (isCrossing(v_i0, v_i1, v_j0, v_j1, cost)) {
+                // swap arcs (v_i0->v_i1), (v_j0->v_j1) with (v_i0->v_j0), (v_i1->v_j1)
+                // To do that, we swap v_j0 and v_i1
+                // as we swap two by two any intermediate vertices
+                // between v_i1 and v_j0
+                int nb_swaps = ceil((j-i)/2.0);
+                for (int k=0; k<nb_swaps; k++) {
+                    swap(sol, i+1+k, j-k);
+                }
+                evaluated -= n-1-j; // the pairs (i,j') with j' > j were not evaluated
+                if (nbEvaluated != NULL) *nbEvaluated += evaluated;
+                INSTR_COUNT(COUNTER_MOVES, evaluated);
+                return true; // crossing detected
+            }
+        }
+    }
+    if (nbEvaluated != NULL) *nbEvaluated += evaluated;
+    INSTR_COUNT(COUNTER_MOVES, evaluated);
+    return false; // no crossing detected
+}
+
+void print_sol(int* sol, int n){
+    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]
+    // side effect: print the tour associated with sol
+    printf("Tour: ");
+    for (int i=0; i<n; i++) {
+        printf("%d ", sol[i]);
+    }
+    printf("\n");
+}
+
+int compute_sol_length(int* sol, int n, const costProvider* cost){
+    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]
+    // return the length of the tour associated with sol
+    int total = 0;
+    for (int i=0; i<n-1; i++) {
+        total += costOf(cost, sol[i], sol[i+1]);
+    }
+    total += costOf(cost, sol[n-1], sol[0]); // don't forget the return to the depot
+    return total;
+}
+
+void print_sol_with_cost(int* sol, int n, const costProvider* cost){
+    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]; total = length of the tour associated with sol
+    // side effect: print the tour associated with sol and its length
+    printf("Tour: ");
+    for (int i=0; i<n; i++) {
+        printf("%d ", sol[i]);
+    }
+    printf(" - Total length = %d\n", compute_sol_length(sol, n, cost));
+}
+
+int greedyLS(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated){
+    // Input: sol[0..n-1] contains a permutation of [0,n-1], and total = length of the tour associated with sol
+    // Output: sol[0..n-1] contains a permutation of [Ø,n-1] such that the corresponding tour does not have crossing edges,
+    //         and the number of 2-opt moves evaluated is added to *nbEvaluated (if not NULL)
+    // Return the length of the tour associated with sol
+    bool has_crossing;
+    INSTR_START(t);
+    while (true){
+        has_crossing = while_procedure(n, sol, total, cost, nbEvaluated);
+        if (!has_crossing) break;
+    }
+    INSTR_PHASE(PHASE_DESCENT, t);
+
+    return compute_sol_length(sol, n, cost);
+}
+
+int greedyLS2(int n, int* sol, int total, const costProvider* cost, uint64_t* nbEvaluated){
+    // Postcondition: best-improvement 2-opt descent of sol; the number of moves evaluated is added to *nbEvaluated (if not NULL)
+    int bestImprovement, ibest, jbest;
+    INSTR_START(t);
+    do{
+        if (nbEvaluated != NULL) *nbEvaluated += (uint64_t)n*(n-1)/2;
+        INSTR_COUNT(COUNTER_MOVES, (uint64_t)n*(n-1)/2);
+        bestImprovement = 0;
+        for (int i=0; i<n-1; i++){
+            for (int j=i+1; j<n; j++){
+                int jplus1 = (j+1)%n;
+                int oldCost = costOf(cost, sol[i], sol[i+1]) + costOf(cost, sol[j], sol[jplus1]);
+                int newCost = costOf(cost, sol[i], sol[j]) + costOf(cost, sol[i+1], sol[jplus1]);
+                if (newCost - oldCost < bestImprovement){
+                    bestImprovement = newCost - oldCost;
+                    ibest = i;
+                    jbest = j;
+                }
+            }
+        }
+        if (bestImprovement < 0){
+            total += bestImprovement;
+            ibest++;
+            while (ibest < jbest){
+                int aux = sol[ibest];
+                sol[ibest] = sol[jbest];
+                sol[jbest] = aux;
+                ibest++; jbest--;
+            }
+        }
+    } while (bestImprovement < 0);
+    INSTR_PHASE(PHASE_DESCENT, t);
+    return total;
+}
+
+int nearestNeighbourTour(int n, const costProvider* cost, int* sol){
+    // input: the number of vertices n, the cost matrix
+    // output: sol[0..n-1] is the tour that starts from 0 and goes each time to the nearest unvisited vertex
+    // return the length of this tour
+    bool visited[n];
+    for (int i=0; i<n; i++) visited[i] = false;
+    sol[0] = 0;
+    visited[0] = true;
+    int total = 0;
+    for (int k=1; k<n; k++){
+        int i = sol[k-1];
+        int next = -1;
+        for (int j=1; j<n; j++)
+            if (!visited[j] && (next < 0 || costOf(cost, i, j) < costOf(cost, i, next))) next = j;
+        visited[next] = true;
+        sol[k] = next;
+        total += costOf(cost, i, next);
+    }
+    return total + costOf(cost, sol[n-1], 0);
+}
+
+int randomTour(int n, const costProvider* cost, rng* r, int* sol){
+    // input: the number of vertices n, the cost matrix, and the random number generator r of the run
+    // output: sol[0..n-1] is a random permutation of [0..n-1]
+    // return the length of the tour associated with sol, or -1 if there is not enough memory
+    int* cand = (int*) malloc(n*sizeof(int)); // candidates for the next vertex
+    if (cand == NULL) return -1;
+    for (int i=0; i<n; i++) cand[i] = i;
+    sol[0] = rngNext(r, n);
+    cand[sol[0]] = n-1;
+    int total = 0;
+    int nbCand = n-1;
+    for (int i=1; i<n; i++){
+        int j = rngNext(r, nbCand);
+        sol[i] = cand[j];
+        cand[j] = cand[--nbCand]; // remove the chosen candidate, replace it by another (unvisited) candidate
+        total += costOf(cost, sol[i-1], sol[i]);
+    }
+    free(cand);
+    return total + costOf(cost, sol[n-1], sol[0]);
+}
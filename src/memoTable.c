@@ -0,0 +1,211 @@
+/*
+ Memoisation tables for the top-down DP solvers
+
+ The dense backend is the n x 2^(n-1) table of computeD_memo. The sparse backend only stores
+ the states that are visited, which is what the pruned solver needs: an open-addressing hash
+ table with linear probing, keyed on (i,s). Slots come from an arena, so an empty table costs
+ nothing until it is written, and the tag of a slot (i+1, or 0 when empty) is the empty marker,
+ which leaves every value, including 0, available to the solvers.
+ When the load factor exceeds MAX_LOAD, a table twice as large is allocated and the slots of the
+ old one are moved a few at a time by the following operations (incremental rehashing), so that
+ no single call pays for a whole rehash.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "memoTable.h"
+#include "instrument.h"
+
+#define INITIAL_CAPACITY 1024
+#define MAX_LOAD 0.5 // linear probing: an unsuccessful search reads 2.5 slots on average at 0.5, 8.5 at 0.75
+#define MIGRATION_STEP 8 // slots of the old table moved by each operation during a growth
+
+static inline uint64_t hashKey(int i, set s){
+    uint64_t h = (uint64_t)s;
+#if SET_BITS == 128
+    h ^= (uint64_t)(s >> 64) * 0x9E3779B97F4A7C15ull;
+#endif
+    h ^= (uint64_t)i * 0xC2B2AE3D27D4EB4Full;
+    // splitmix64 finaliser
+    h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27; h *= 0x94D049BB133111EBull;
+    h ^= h >> 31;
+    return h;
+}
+
+static bool allocHash(memoTable* m, memoHash* h, size_t capacity){
+    h->slots = (memoSlot*) arenaAlloc(m->storage, capacity*sizeof(memoSlot));
+    h->capacity = (h->slots == NULL) ? 0 : capacity;
+    h->count = 0;
+    return h->slots != NULL;
+}
+
+static memoSlot* findSlot(memoHash* h, int i, set s, uint64_t* length){
+    // Postcondition: return the slot of (i,s) in h, or the empty slot where it would be inserted,
+    //                and add the number of slots read to length
+    size_t mask = h->capacity - 1;
+    size_t k = hashKey(i, s) & mask;
+    (*length)++;
+    while (h->slots[k].tag != 0 && (h->slots[k].tag != i+1 || h->slots[k].s != s)){
+        k = (k + 1) & mask;
+        (*length)++;
+    }
+    return &h->slots[k];
+}
+
+static memoSlot* probe(memoTable* m, memoHash* h, int i, set s){
+    // Postcondition: same as findSlot, and the probe statistics of m are updated
+    uint64_t length = 0;
+    memoSlot* slot = findSlot(h, i, s, &length);
+    m->probes += length;
+    if (length > m->maxProbe) m->maxProbe = length;
+    return slot;
+}
+
+static void migrate(memoTable* m, size_t nbSlots){
+    // Postcondition: the next nbSlots slots of the old table are moved to the current one
+    if (m->old.capacity == 0) return;
+    size_t end = m->migrated + nbSlots;
+    if (end > m->old.capacity) end = m->old.capacity;
+    for (; m->migrated < end; m->migrated++){
+        memoSlot* from = &m->old.slots[m->migrated];
+        if (from->tag == 0) continue;
+        uint64_t length = 0; // moves are not lookups, and are left out of the probe statistics
+        memoSlot* to = findSlot(&m->cur, from->tag - 1, from->s, &length);
+        *to = *from;
+        m->cur.count++;
+        m->old.count--;
+    }
+    if (m->migrated == m->old.capacity){
+        arenaRelease(m->storage, m->old.slots, m->old.capacity*sizeof(memoSlot));
+        m->old.slots = NULL;
+        m->old.capacity = m->old.count = 0;
+    }
+}
+
+memoTable* memoCreate(memoKind kind, int n){
+    // Postcondition: return an empty table for instances of n vertices, or NULL if it cannot be allocated
+    if (kind == MEMO_DENSE && n > DENSE_MAX_VERTICES) return NULL;
+    INSTR_START(t);
+    memoTable* m = (memoTable*) calloc(1, sizeof(memoTable));
+    if (m == NULL) return NULL;
+    m->kind = kind;
+    m->n = n;
+    m->maxProbe = (kind == MEMO_DENSE) ? 1 : 0; // a dense access reads a single cell
+    // dense rows are mostly visited: huge pages save page faults and TLB misses; hash tables keep base pages for arenaRelease
+    m->storage = arenaCreatePages((size_t)64 << 20, kind == MEMO_DENSE ? ARENA_PAGES_TRANSPARENT : ARENA_PAGES_SMALL);
+    if (m->storage == NULL){
+        free(m);
+        return NULL;
+    }
+    bool ok = true;
+    if (kind == MEMO_DENSE){
+        m->rows = (int32_t**) arenaAlloc(m->storage, n*sizeof(int32_t*));
+        ok = (m->rows != NULL);
+        for (int i=0; ok && i<n; i++){
+            m->rows[i] = (int32_t*) arenaAlloc(m->storage, ((size_t)1 << (n-1))*sizeof(int32_t));
+            ok = (m->rows[i] != NULL);
+        }
+    } else {
+        ok = allocHash(m, &m->cur, INITIAL_CAPACITY);
+    }
+    if (!ok){
+        memoFree(m);
+        return NULL;
+    }
+    INSTR_PHASE(PHASE_ALLOC, t);
+    return m;
+}
+
+void memoFree(memoTable* m){
+    if (m == NULL) return;
+    arenaFree(m->storage);
+    free(m);
+}
+
+bool memoGet(memoTable* m, int i, set s, int* value){
+    // Postcondition: if (i,s) has been stored, value is set to its value and true is returned
+    m->lookups++;
+    if (m->kind == MEMO_DENSE){
+        m->probes++;
+        int32_t v = m->rows[i][setIndex(s)];
+        if (v == 0){
+            INSTR_COUNT(COUNTER_MEMO_MISS, 1);
+            return false;
+        }
+        INSTR_COUNT(COUNTER_MEMO_HIT, 1);
+        *value = v - 1;
+        return true;
+    }
+    migrate(m, MIGRATION_STEP);
+    memoSlot* slot = probe(m, &m->cur, i, s);
+    if (slot->tag == 0 && m->old.capacity > 0) slot = probe(m, &m->old, i, s);
+    if (slot->tag == 0){
+        INSTR_COUNT(COUNTER_MEMO_MISS, 1);
+        return false;
+    }
+    INSTR_COUNT(COUNTER_MEMO_HIT, 1);
+    *value = slot->value;
+    return true;
+}
+
+void memoPut(memoTable* m, int i, set s, int value){
+    // Precondition: 0 <= value < INT32_MAX
+    // Postcondition: the value of (i,s) is value
+    m->lookups++;
+    if (m->kind == MEMO_DENSE){
+        m->probes++;
+        m->rows[i][setIndex(s)] = value + 1;
+        return;
+    }
+    migrate(m, MIGRATION_STEP);
+    memoSlot* slot = probe(m, &m->cur, i, s);
+    if (slot->tag == 0 && m->old.capacity > 0){
+        // slots of old are left in place when moved, so a key found there has not been migrated yet
+        memoSlot* oldSlot = probe(m, &m->old, i, s);
+        if (oldSlot->tag != 0){
+            oldSlot->value = value;
+            return;
+        }
+    }
+    if (slot->tag == 0){
+        slot->tag = i+1;
+        slot->s = s;
+        m->cur.count++;
+    }
+    slot->value = value;
+
+    if (m->cur.count > MAX_LOAD*m->cur.capacity){
+        migrate(m, m->old.capacity); // a growth must not start before the previous one is over
+        memoHash bigger;
+        if (!allocHash(m, &bigger, 2*m->cur.capacity)){
+            fprintf(stderr, "Not enough memory to grow the memoisation table.\n");
+            exit(EXIT_FAILURE);
+        }
+        m->old = m->cur;
+        m->cur = bigger;
+        m->migrated = 0;
+    }
+}
+
+size_t memoCount(const memoTable* m){
+    // Postcondition: return the number of sparse states stored (0 for the dense backend, which does not count them)
+    return m->cur.count + m->old.count;
+}
+
+double memoLoadFactor(const memoTable* m){
+    // Postcondition: return the load factor of the current table once all states are in it
+    // (during a growth, the states not yet migrated from the old table are counted)
+    if (m->kind == MEMO_DENSE) return 0;
+    return (double)(m->cur.count + m->old.count) / m->cur.capacity;
+}
+
+size_t memoBytes(const memoTable* m){
+    // Postcondition: return the number of bytes of the live table(s)
+    if (m->kind == MEMO_DENSE) return m->n*((size_t)1 << (m->n-1))*sizeof(int32_t);
+    return (m->cur.capacity + m->old.capacity)*sizeof(memoSlot);
+}
+
+const char* memoKindName(memoKind kind){
+    return (kind == MEMO_DENSE) ? "dense" : "sparse";
+}
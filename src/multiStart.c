@@ -0,0 +1,137 @@
+/*
+ Parallel multi-start local search
+
+ Each restart builds a random tour and improves it with greedyLS2, or with neighbourLS when
+ candidate lists are given. Restart r draws its tour from the stream r of the seed (see rng.h),
+ and the threads take the next restart number from a shared counter: a restart gives the same tour
+ whichever thread runs it.
+ The global best is a single 64-bit word, (length << 32) | restart, lowered with compare-and-swap,
+ so that equal lengths are broken by the smallest restart number and the result does not depend on
+ the order in which threads finish. Each thread keeps its own best tour, and the tour of the
+ winning restart is copied at the end.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "multiStart.h"
+#include "localSearch.h"
+#include "rng.h"
+#include "timer.h"
+#include "instrument.h"
+
+typedef struct {
+    int n;
+    const costProvider* cost;
+    const candidateLists* cand;
+    int moves;
+    int nbRestarts;
+    uint64_t seed;
+    _Alignas(64) atomic_int next;         // next restart to run
+    _Alignas(64) _Atomic uint64_t best;   // (length << 32) | restart of the best tour found so far
+    atomic_bool failed;                   // a restart ran out of memory: the threads stop
+} multiStartContext;
+
+typedef struct {
+    multiStartContext* ctx;
+    int* sol;          // current tour
+    int* bestSol;      // best tour found by this thread
+    uint64_t bestKey;  // key of bestSol (UINT64_MAX if none)
+    int restartsDone;
+    pthread_t thread;
+} msWorker;
+
+static void* runRestarts(void* arg){
+    msWorker* w = (msWorker*) arg;
+    multiStartContext* ctx = w->ctx;
+    int n = ctx->n;
+    while (true){
+        int r = atomic_fetch_add_explicit(&ctx->next, 1, memory_order_relaxed);
+        if (r >= ctx->nbRestarts || atomic_load_explicit(&ctx->failed, memory_order_relaxed)) break;
+        rng gen;
+        rngInit(&gen, ctx->seed, r);
+        int total = randomTour(n, ctx->cost, &gen, w->sol);
+        if (total >= 0 && ctx->cand == NULL) total = greedyLS2(n, w->sol, total, ctx->cost, NULL);
+        else if (total >= 0) total = neighbourLS(n, w->sol, total, ctx->cost, ctx->cand, ctx->moves, NULL);
+        if (total < 0){
+            atomic_store_explicit(&ctx->failed, true, memory_order_relaxed);
+            break;
+        }
+        w->restartsDone++;
+
+        uint64_t key = ((uint64_t)total << 32) | (uint32_t)r;
+        if (key < w->bestKey){
+            w->bestKey = key;
+            memcpy(w->bestSol, w->sol, n*sizeof(int));
+        }
+        uint64_t cur = atomic_load_explicit(&ctx->best, memory_order_relaxed);
+        while (key < cur && !atomic_compare_exchange_weak_explicit(&ctx->best, &cur, key, memory_order_relaxed, memory_order_relaxed));
+    }
+    INSTR_MERGE();
+    return NULL;
+}
+
+/**
+ * Multi-start local search on nbThreads threads
+ * Input: cand = candidate lists of neighbourLS with the move types moves, or NULL for greedyLS2
+ * Output: best[0..n-1] is the best tour of the nbRestarts restarts, which only depends on seed
+ * Return its length, or -1 if there is not enough memory
+ */
+int multiStartLS(int n, const costProvider* cost, const candidateLists* cand, int moves, int nbRestarts, int nbThreads,
+                 uint64_t seed, int* best, msStats* stats){
+    double start = wallTime();
+    multiStartContext* ctx = (multiStartContext*) aligned_alloc(64, sizeof(multiStartContext));
+    msWorker* workers = (msWorker*) calloc(nbThreads, sizeof(msWorker));
+    if (ctx == NULL || workers == NULL){
+        free(ctx);
+        free(workers);
+        return -1;
+    }
+    ctx->n = n;
+    ctx->cost = cost;
+    ctx->cand = cand;
+    ctx->moves = moves;
+    ctx->nbRestarts = nbRestarts;
+    ctx->seed = seed;
+    atomic_init(&ctx->next, 0);
+    atomic_init(&ctx->best, UINT64_MAX);
+    atomic_init(&ctx->failed, false);
+
+    bool ok = true;
+    for (int w=0; w<nbThreads; w++){
+        workers[w].ctx = ctx;
+        workers[w].bestKey = UINT64_MAX;
+        workers[w].sol = (int*) malloc(n*sizeof(int));
+        workers[w].bestSol = (int*) malloc(n*sizeof(int));
+        if (workers[w].sol == NULL || workers[w].bestSol == NULL) ok = false;
+    }
+    // thread 0 is the calling thread
+    int launched = 1;
+    for (int w=1; ok && w<nbThreads; w++, launched++)
+        if (pthread_create(&workers[w].thread, NULL, runRestarts, &workers[w]) != 0) break;
+    if (ok) runRestarts(&workers[0]);
+    for (int w=1; w<launched; w++) pthread_join(workers[w].thread, NULL);
+
+    int length = -1;
+    uint64_t key = atomic_load(&ctx->best);
+    if (atomic_load(&ctx->failed)) ok = false;
+    for (int w=0; ok && w<nbThreads; w++){
+        if (workers[w].bestKey == key){
+            memcpy(best, workers[w].bestSol, n*sizeof(int));
+            length = (int)(key >> 32);
+            if (stats != NULL) stats->bestRestart = (int)(uint32_t)key;
+        }
+        if (stats != NULL && stats->restartsDone != NULL) stats->restartsDone[w] = workers[w].restartsDone;
+    }
+    for (int w=0; w<nbThreads; w++){
+        free(workers[w].sol);
+        free(workers[w].bestSol);
+    }
+    free(workers);
+    free(ctx);
+    if (stats != NULL) stats->seconds = wallTime() - start;
+    return length;
+}
@@ -0,0 +1,575 @@
+/*
+ Local search restricted to candidate lists, for large instances
+
+ greedyLS2 scans the n^2 pairs of edges after every move. Here:
+ - a 2-opt move replacing (a,succ(a)) and (c,succ(c)) by (a,c) and (succ(a),succ(c)) can only
+   improve the tour if cost(a,c) < cost(a,succ(a)), so c is searched among the k nearest
+   vertices of a only, in increasing order of cost, stopping at the first one that is too far
+   (and symmetrically with the predecessors);
+ - a vertex whose neighbourhood has been searched without success is not searched again until one
+   of its tour edges changes (don't-look bits): the vertices to search are kept in a FIFO queue,
+   which initially contains all vertices, and the four end points of each move are pushed back;
+ - pos[v] is the position of v in sol, so that succ, pred and the segment to reverse are found in O(1).
+   On large tours, reversing up to n/2 positions per move dominates: the tour is then stored in a
+   two-level doubly-linked list instead (tourList.h), whose reversals cost O(sqrt(n)), and is
+   written back to sol at the end (by default, only for searches from all vertices).
+ Besides 2-opt, the search may try Or-opt moves (a segment of 1 to 3 vertices is moved between two
+ other adjacent vertices, in either orientation) and or-3opt moves (two consecutive segments are
+ exchanged). The delta of each move only involves the 3 removed and the 3 added edges. Every move is
+ applied as a sequence of 2-opt moves, each of which reverses the shorter of the two paths it
+ separates: the tour may then be read backwards in sol, which does not change its edges.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "neighbourLS.h"
+#include "tourList.h"
+#include "timer.h"
+#include "instrument.h"
+
+lsTour lsTourChoice = LS_TOUR_AUTO;
+
+static inline void insertCandidate(int* list, double* dist, int* size, int k, int j, double d){
+    // Postcondition: j is inserted in the list of the (at most k) nearest vertices sorted by increasing distance d
+    if (*size == k && d >= dist[k-1]) return;
+    int p = (*size < k) ? (*size)++ : k-1;
+    while (p > 0 && dist[p-1] > d){
+        list[p] = list[p-1];
+        dist[p] = dist[p-1];
+        p--;
+    }
+    list[p] = j;
+    dist[p] = d;
+}
+
+static bool gridCandidates(candidateLists* c, const costProvider* cost){
+    // Postcondition: the lists of c are computed from a grid of about 2 vertices per cell, in O(nk) on uniform
+    //                instances, or false is returned if there is not enough memory
+    // The cells around the cell of i are searched ring by ring, until the k-th vertex found is closer than the next ring.
+    int n = c->n, k = c->k;
+    const double* xy = cost->xy;
+    double minX = xy[0], maxX = xy[0], minY = xy[1], maxY = xy[1];
+    for (int i=1; i<n; i++){
+        if (xy[2*i] < minX) minX = xy[2*i];
+        if (xy[2*i] > maxX) maxX = xy[2*i];
+        if (xy[2*i+1] < minY) minY = xy[2*i+1];
+        if (xy[2*i+1] > maxY) maxY = xy[2*i+1];
+    }
+    int side = (int)sqrt(n/2.0);
+    if (side < 1) side = 1;
+    double w = (maxX > minX) ? (maxX - minX)/side : 1, h = (maxY > minY) ? (maxY - minY)/side : 1;
+    double ring = (w < h) ? w : h; // distance covered by each ring
+    int* cellOf = (int*) malloc(n*sizeof(int));
+    int* first = (int*) calloc((size_t)side*side + 1, sizeof(int));
+    int* order = (int*) malloc(n*sizeof(int));
+    double* dist = (double*) malloc(k*sizeof(double));
+    if (cellOf == NULL || first == NULL || order == NULL || dist == NULL){
+        free(cellOf);
+        free(first);
+        free(order);
+        free(dist);
+        return false;
+    }
+    // counting sort of the vertices by cell
+    for (int i=0; i<n; i++){
+        int cx = (int)((xy[2*i] - minX)/w), cy = (int)((xy[2*i+1] - minY)/h);
+        if (cx >= side) cx = side-1;
+        if (cy >= side) cy = side-1;
+        cellOf[i] = cy*side + cx;
+        first[cellOf[i]+1]++;
+    }
+    for (int q=0; q<side*side; q++) first[q+1] += first[q];
+    int* next = (int*) malloc((size_t)side*side*sizeof(int));
+    if (next == NULL){
+        free(cellOf);
+        free(first);
+        free(order);
+        free(dist);
+        return false;
+    }
+    memcpy(next, first, (size_t)side*side*sizeof(int));
+    for (int i=0; i<n; i++) order[next[cellOf[i]]++] = i;
+    free(next);
+
+    for (int i=0; i<n; i++){
+        int* list = c->neighbours + (size_t)i*k;
+        int size = 0;
+        int cx = cellOf[i] % side, cy = cellOf[i] / side;
+        for (int r=0; r<=side; r++){
+            for (int y=cy-r; y<=cy+r; y++){
+                if (y < 0 || y >= side) continue;
+                // the whole row on the top and bottom sides of the ring, its two ends otherwise
+                int step = (y == cy-r || y == cy+r) ? 1 : 2*r;
+                for (int x=cx-r; x<=cx+r; x += (step > 0 ? step : 1)){
+                    if (x < 0 || x >= side) continue;
+                    int q = y*side + x;
+                    for (int p=first[q]; p<first[q+1]; p++){
+                        int j = order[p];
+                        if (j == i) continue;
+                        // ordered by cost, then by index, so that the lists are those of the matrix modes
+                        insertCandidate(list, dist, &size, k, j, (double)costOf(cost, i, j)*n + j);
+                    }
+                }
+            }
+            // the vertices outside the rings searched are at a distance of at least r*ring
+            if (size == k && dist[k-1] < (double)metricLowerBound(cost->metric, r*ring)*n) break;
+        }
+    }
+    free(cellOf);
+    free(first);
+    free(order);
+    free(dist);
+    return true;
+}
+
+candidateLists* candidatesCreate(int n, const costProvider* cost, int k){
+    // Precondition: 1 <= k
+    // Postcondition: return the lists of the min(k,n-1) nearest vertices of each vertex, or NULL if there is not enough memory
+    // Without a matrix, the lists come from a grid on the coordinates, as scanning the n^2 pairs would dominate the search.
+    if (k > n-1) k = n-1;
+    candidateLists* c = (candidateLists*) malloc(sizeof(candidateLists));
+    if (c == NULL) return NULL;
+    c->n = n;
+    c->k = k;
+    c->neighbours = (int*) malloc((size_t)n*(k > 0 ? k : 1)*sizeof(int));
+    if (c->neighbours == NULL){
+        free(c);
+        return NULL;
+    }
+    if (cost->kind == COST_COORDS && cost->metric != METRIC_GEO && k > 0){
+        if (gridCandidates(c, cost)) return c;
+        candidatesFree(c);
+        return NULL;
+    }
+    for (int i=0; i<n; i++){
+        int* list = c->neighbours + (size_t)i*k;
+        int size = 0;
+        // insertion into a sorted list of at most k vertices
+        for (int j=0; j<n; j++){
+            if (j == i) continue;
+            if (size == k && costOf(cost, i, j) >= costOf(cost, i, list[k-1])) continue;
+            int p = (size < k) ? size++ : k-1;
+            while (p > 0 && costOf(cost, i, list[p-1]) > costOf(cost, i, j)){
+                list[p] = list[p-1];
+                p--;
+            }
+            list[p] = j;
+        }
+    }
+    return c;
+}
+
+void candidatesFree(candidateLists* c){
+    if (c == NULL) return;
+    free(c->neighbours);
+    free(c);
+}
+
+static inline int succ(const lsSearch* t, int v){
+    if (t->list != NULL) return tourNext(t->list, v);
+    int p = t->pos[v] + 1;
+    return t->sol[p == t->n ? 0 : p];
+}
+
+static inline int pred(const lsSearch* t, int v){
+    if (t->list != NULL) return tourPrev(t->list, v);
+    int p = t->pos[v] - 1;
+    return t->sol[p < 0 ? t->n-1 : p];
+}
+
+static inline void push(lsSearch* t, int v){
+    if (t->queued[v]) return;
+    t->queued[v] = true;
+    int p = t->head + t->size++;
+    t->queue[p >= t->n ? p - t->n : p] = v;
+}
+
+static inline int pop(lsSearch* t){
+    // Precondition: the queue is not empty
+    int v = t->queue[t->head];
+    if (++t->head == t->n) t->head = 0;
+    t->size--;
+    t->queued[v] = false;
+    return v;
+}
+
+static void reverse(lsSearch* t, int from, int to){
+    // Postcondition: the vertices at positions from, from+1, ..., to (modulo n) are in reverse order
+    int n = t->n;
+    int len = to - from;
+    if (len < 0) len += n;
+    for (int k=0; k<(len+1)/2; k++){
+        int a = t->sol[from], b = t->sol[to];
+        t->sol[from] = b;
+        t->pos[b] = from;
+        t->sol[to] = a;
+        t->pos[a] = to;
+        if (++from == n) from = 0;
+        if (--to < 0) to = n-1;
+    }
+}
+
+static void logMove(lsSearch* t, int a, int b, int c, int d){
+    // Postcondition: the 2-opt move (a,b,c,d) is appended to the log (or t->failed is set)
+    if (t->logSize + 4 > t->logCapacity){
+        int capacity = t->logCapacity > 0 ? 2*t->logCapacity : 64;
+        int* log = (int*) realloc(t->log, capacity*sizeof(int));
+        if (log == NULL){
+            t->failed = true;
+            return;
+        }
+        t->log = log;
+        t->logCapacity = capacity;
+    }
+    int* m = t->log + t->logSize;
+    m[0] = a; m[1] = b; m[2] = c; m[3] = d;
+    t->logSize += 4;
+}
+
+static void make2opt(lsSearch* t, int a, int b, int c, int d){
+    // Precondition: (a,b) and (c,d) are edges of the tour, and b follows a in the same direction as d follows c
+    // Postcondition: they are replaced by (a,c) and (b,d)
+    if (b == c) return; // the edges are already (a,c) and (b,d)
+    if (t->logging) logMove(t, a, b, c, d);
+    if (t->list != NULL){
+        tourFlip(t->list, a, b, c, d);
+        return;
+    }
+    int n = t->n;
+    int from, to;   // the path from b to c, read in the direction of sol
+    if (succ(t, a) == b){
+        from = t->pos[b];
+        to = t->pos[c];
+    } else {
+        from = t->pos[c];
+        to = t->pos[b];
+    }
+    int len = to - from + 1;
+    if (len <= 0) len += n;
+    if (2*len <= n) reverse(t, from, to);
+    else if (n - len > 1) reverse(t, to+1 == n ? 0 : to+1, from == 0 ? n-1 : from-1); // the other side, from d to a
+}
+
+static int improve2opt(lsSearch* t, int a, const costProvider* cost, const candidateLists* c, lsStats* stats){
+    // Postcondition: apply the best improving 2-opt move which adds an edge (a,c), with c a candidate of a,
+    //                and return its (negative) gain, or return 0 if there is none
+    const int* list = c->neighbours + (size_t)a*c->k;
+    int best = 0, bestC = -1;
+    bool bestSucc = true;
+    for (int dir=0; dir<2; dir++){
+        bool forward = (dir == 0);
+        int b = forward ? succ(t, a) : pred(t, a);
+        int dab = costOf(cost, a, b);
+        for (int m=0; m<c->k; m++){
+            int cc = list[m];
+            int dac = costOf(cost, a, cc);
+            if (dac >= dab) break; // the next candidates are even farther
+            int d = forward ? succ(t, cc) : pred(t, cc);
+            if (cc == b || d == a) continue;
+            stats->evaluated[LS_2OPT]++;
+            int delta = dac + costOf(cost, b, d) - dab - costOf(cost, cc, d);
+            if (delta < best){
+                best = delta;
+                bestC = cc;
+                bestSucc = forward;
+            }
+        }
+    }
+    if (best == 0) return 0;
+    int b = bestSucc ? succ(t, a) : pred(t, a);
+    int d = bestSucc ? succ(t, bestC) : pred(t, bestC);
+    make2opt(t, a, b, bestC, d);
+    push(t, a);
+    push(t, b);
+    push(t, bestC);
+    push(t, d);
+    stats->applied[LS_2OPT]++;
+    return best;
+}
+
+static inline bool inPath(const lsSearch* t, int v, int first, int last){
+    // Postcondition: return true if v is on the path from first to last, in the direction of sol
+    if (t->list != NULL) return tourBetween(t->list, first, v, last);
+    int n = t->n;
+    int ov = t->pos[v] - t->pos[first];
+    int ol = t->pos[last] - t->pos[first];
+    if (ov < 0) ov += n;
+    if (ol < 0) ol += n;
+    return ov <= ol;
+}
+
+static int improveOrOpt(lsSearch* t, int a, const costProvider* cost, const candidateLists* c, lsStats* stats){
+    // Postcondition: apply the best improving move of a segment of 1 to 3 vertices starting at a (in the direction of sol)
+    //                next to a candidate of one of its ends, and return its (negative) gain, or return 0 if there is none
+    int best = 0, bestLen = 0, bestX = -1;
+    bool bestReversed = false;
+    int s2 = a;
+    for (int len=1; len<=3 && len+3<=t->n; len++, s2 = succ(t, s2)){
+        int s1 = a, p = pred(t, s1), nx = succ(t, s2);
+        int removal = costOf(cost, p, nx) - costOf(cost, p, s1) - costOf(cost, s2, nx);
+        if (removal >= 0) continue;
+        for (int e=0; e<2; e++){
+            // edges (cc,s1) or (s2,cc) are added, with cc a candidate of s1 or s2
+            int end = (e == 0) ? s1 : s2;
+            const int* list = c->neighbours + (size_t)end*c->k;
+            for (int m=0; m<c->k; m++){
+                int cc = list[m];
+                if (costOf(cost, end, cc) + removal >= 0) break;
+                if (inPath(t, cc, s1, s2)) continue;
+                for (int o=0; o<2; o++){
+                    // insertion between x and y = succ(x): x s1..s2 y (forward) or x s2..s1 y (reversed)
+                    bool reversed = (o == 1);
+                    if (len == 1 && reversed) continue; // same move
+                    bool ccFirst = (e == 0) != reversed; // cc is x
+                    int x = ccFirst ? cc : pred(t, cc);
+                    int y = ccFirst ? succ(t, cc) : cc;
+                    if (x == p || y == p || x == nx || inPath(t, x, s1, s2) || inPath(t, y, s1, s2)) continue;
+                    stats->evaluated[LS_OROPT]++;
+                    int delta = removal - costOf(cost, x, y) + (reversed ? costOf(cost, x, s2) + costOf(cost, s1, y) : costOf(cost, x, s1) + costOf(cost, s2, y));
+                    if (delta < best){
+                        best = delta;
+                        bestLen = len;
+                        bestX = x;
+                        bestReversed = reversed;
+                    }
+                }
+            }
+        }
+    }
+    if (best == 0) return 0;
+    int s1 = a;
+    s2 = a;
+    for (int k=1; k<bestLen; k++) s2 = succ(t, s2);
+    int p = pred(t, s1), nx = succ(t, s2), x = bestX, y = succ(t, x);
+    make2opt(t, p, s1, x, y);    // p x .. nx s2..s1 y
+    make2opt(t, p, x, nx, s2);   // p nx .. x s2..s1 y
+    if (!bestReversed) make2opt(t, x, s2, s1, y); // x s1..s2 y
+    push(t, p);
+    push(t, nx);
+    push(t, s1);
+    push(t, s2);
+    push(t, x);
+    push(t, y);
+    stats->applied[LS_OROPT]++;
+    return best;
+}
+
+/**
+ * Exchange of two consecutive segments (or-3opt move, or double bridge): a b1..b2 c1..c2 d becomes a c1..c2 b1..b2 d
+ * Precondition: b1 = succ(a), c1 = succ(b2) and d = succ(c2), with the 6 vertices on the tour in this order
+ */
+void lsSearchExchange(lsSearch* t, int a, int b1, int b2, int c1, int c2, int d){
+    make2opt(t, a, b1, c2, d);     // a c2..c1 b2..b1 d
+    make2opt(t, a, c2, c1, b2);    // a c1..c2 b2..b1 d
+    make2opt(t, c2, b2, b1, d);    // a c1..c2 b1..b2 d
+}
+
+static int improveOr3opt(lsSearch* t, int a, const costProvider* cost, const candidateLists* c, lsStats* stats){
+    // Postcondition: apply the best improving move t1 [t2..t5] [t6..t3] t4 -> t1 [t6..t3] [t2..t5] t4 with t1 = a,
+    //                t3 a candidate of t2 and t5 a candidate of t4, and return its (negative) gain, or return 0 if there is none
+    int t1 = a, t2 = succ(t, a);
+    int best = 0, best3 = -1, best5 = -1;
+    const int* list2 = c->neighbours + (size_t)t2*c->k;
+    for (int m=0; m<c->k; m++){
+        int t3 = list2[m];
+        int g1 = costOf(cost, t1, t2) - costOf(cost, t2, t3);
+        if (g1 <= 0) break;
+        if (t3 == t1) continue;
+        int t4 = succ(t, t3);
+        if (t4 == t1 || t3 == t2) continue;
+        const int* list4 = c->neighbours + (size_t)t4*c->k;
+        for (int q=0; q<c->k; q++){
+            int t5 = list4[q];
+            int g2 = g1 + costOf(cost, t3, t4) - costOf(cost, t4, t5);
+            if (g2 <= 0) break;
+            if (t5 == t3 || !inPath(t, t5, t2, t3)) continue;
+            int t6 = succ(t, t5);
+            stats->evaluated[LS_OR3OPT]++;
+            int delta = costOf(cost, t1, t6) - costOf(cost, t5, t6) - g2;
+            if (delta < best){
+                best = delta;
+                best3 = t3;
+                best5 = t5;
+            }
+        }
+    }
+    if (best == 0) return 0;
+    int t3 = best3, t4 = succ(t, t3), t5 = best5, t6 = succ(t, t5);
+    lsSearchExchange(t, t1, t2, t5, t6, t3, t4);
+    push(t, t1);
+    push(t, t2);
+    push(t, t3);
+    push(t, t4);
+    push(t, t5);
+    push(t, t6);
+    stats->applied[LS_OR3OPT]++;
+    return best;
+}
+
+/**
+ * State of the local search on the tour sol[0..n-1], which is searched in place
+ * (stored in a two-level list instead of a position array if useList)
+ * Return the state, or NULL if there is not enough memory
+ */
+lsSearch* lsSearchCreate(int n, int* sol, bool useList){
+    lsSearch* t = (lsSearch*) calloc(1, sizeof(lsSearch));
+    if (t == NULL) return NULL;
+    t->n = n;
+    t->sol = sol;
+    t->pos = (int*) malloc(n*sizeof(int));
+    t->queue = (int*) malloc(n*sizeof(int));
+    t->queued = (bool*) calloc(n, sizeof(bool));
+    t->list = useList ? tourListCreate(n, sol) : NULL;
+    if (t->pos == NULL || t->queue == NULL || t->queued == NULL || (useList && t->list == NULL)){
+        lsSearchFree(t);
+        return NULL;
+    }
+    for (int p=0; p<n; p++) t->pos[sol[p]] = p;
+    return t;
+}
+
+void lsSearchFree(lsSearch* t){
+    if (t == NULL) return;
+    free(t->pos);
+    free(t->queue);
+    free(t->queued);
+    free(t->log);
+    tourListFree(t->list);
+    free(t);
+}
+
+void lsSearchReload(lsSearch* t){
+    // Postcondition: the search continues from sol, and the log is cleared
+    for (int p=0; p<t->n; p++) t->pos[t->sol[p]] = p;
+    if (t->list != NULL){
+        tourListFree(t->list);
+        t->list = tourListCreate(t->n, t->sol);
+        if (t->list == NULL) t->failed = true; // the search goes on with the positions
+    }
+    t->logSize = 0;
+}
+
+void lsSearchSync(lsSearch* t){
+    // Postcondition: sol is the tour searched (it only lags behind when the tour is stored in a list)
+    if (t->list != NULL) tourListToArray(t->list, t->sol[0], t->sol);
+}
+
+int lsSearchNext(const lsSearch* t, int v){
+    return succ(t, v);
+}
+
+void lsSearchMark(lsSearch* t){
+    // Postcondition: the moves applied from now on are logged, until they are undone or the next mark
+    t->logging = true;
+    t->logSize = 0;
+}
+
+void lsSearchUndo(lsSearch* t){
+    // Precondition: lsSearchMark has been called, and t->failed is false
+    // Postcondition: the tour has the edges it had at the last mark (it may be read in another direction)
+    bool logging = t->logging;
+    t->logging = false;
+    for (int m=t->logSize-4; m>=0; m-=4){
+        // (a,b),(c,d) were replaced by (a,c),(b,d), with c following a as d follows b
+        const int* e = t->log + m;
+        make2opt(t, e[0], e[2], e[1], e[3]);
+    }
+    t->logSize = 0;
+    t->logging = logging;
+}
+
+/**
+ * Local search with candidate lists, don't-look bits and a position array, from the current state
+ * Input: total = length of the tour of s, moves is a combination of LS_MOVE_BIT(m) for the move types m to try,
+ *        in the order of lsMove, and start[0..nbStart-1] are the vertices whose don't-look bits are off
+ *        (all vertices if start is NULL)
+ * Output: the tour of s is a tour that no move of these types between candidates can improve
+ *         (around the start vertices and the changes made since, when start is given)
+ *         and stats (if not NULL) contains the number of moves evaluated and applied for each type
+ * Return the length of the tour, or -1 if there is not enough memory (for the log of the moves)
+ */
+int lsSearchRun(lsSearch* t, int total, const costProvider* cost, const candidateLists* c, int moves,
+                const int* start, int nbStart, lsStats* stats){
+    lsStats local;
+    if (stats == NULL) stats = &local;
+    *stats = (lsStats){0};
+    if (t->n < 5) return total;
+    double startTime = wallTime();
+    if (start == NULL)
+        for (int v=0; v<t->n; v++) push(t, v);
+    for (int k=0; start != NULL && k<nbStart; k++) push(t, start[k]);
+    int (*improve[LS_NB_MOVES])(lsSearch*, int, const costProvider*, const candidateLists*, lsStats*) = {improve2opt, improveOrOpt, improveOr3opt};
+    while (t->size > 0){
+        int a = pop(t);
+        // the first type of move that improves the tour is applied (the search of a then resumes later from the queue)
+        for (int m=0; m<LS_NB_MOVES; m++){
+            if (!(moves & LS_MOVE_BIT(m))) continue;
+            uint64_t cycles = cycleCount();
+            int delta = improve[m](t, a, cost, c, stats);
+            stats->cycles[m] += cycleCount() - cycles;
+            if (delta < 0){
+                total += delta;
+                break;
+            }
+        }
+    }
+    stats->seconds = wallTime() - startTime;
+    INSTR_PHASE(PHASE_DESCENT, startTime);
+    INSTR_COUNT(COUNTER_MOVES, stats->evaluated[LS_2OPT] + stats->evaluated[LS_OROPT] + stats->evaluated[LS_OR3OPT]);
+    return t->failed ? -1 : total;
+}
+
+/**
+ * Local search with candidate lists, don't-look bits and a position array
+ * Input: sol[0..n-1] contains a permutation of [0,n-1], total = length of the tour associated with sol,
+ *        moves is a combination of LS_MOVE_BIT(m) for the move types m to try, in the order of lsMove,
+ *        and start[0..nbStart-1] are the vertices whose don't-look bits are off (all vertices if start is NULL)
+ * Output: sol[0..n-1] is a tour that no move of these types between candidates can improve
+ *         (around the start vertices and the changes made since, when start is given)
+ *         and stats (if not NULL) contains the number of moves evaluated and applied for each type
+ * Return the length of the tour associated with sol, or -1 if there is not enough memory
+ */
+int neighbourLSFrom(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves,
+                    const int* start, int nbStart, lsStats* stats){
+    if (n < 5){
+        if (stats != NULL) *stats = (lsStats){0};
+        return total;
+    }
+    // a search from a few start vertices makes few moves, so building the list would cost more than it saves
+    bool useList = (lsTourChoice == LS_TOUR_LIST) || (lsTourChoice == LS_TOUR_AUTO && n >= LS_LIST_MIN_VERTICES && start == NULL);
+    lsSearch* t = lsSearchCreate(n, sol, useList);
+    if (t == NULL) return -1;
+    total = lsSearchRun(t, total, cost, c, moves, start, nbStart, stats);
+    lsSearchSync(t);
+    lsSearchFree(t);
+    return total;
+}
+
+int neighbourLS(int n, int* sol, int total, const costProvider* cost, const candidateLists* c, int moves, lsStats* stats){
+    return neighbourLSFrom(n, sol, total, cost, c, moves, NULL, 0, stats);
+}
+
+int neighbourLS2(int n, int* sol, int total, const costProvider* cost, const candidateLists* c){
+    // 2-opt only, see neighbourLS
+    return neighbourLS(n, sol, total, cost, c, LS_MOVE_BIT(LS_2OPT), NULL);
+}
+
+const char* lsMoveName(lsMove m){
+    static const char* names[LS_NB_MOVES] = {"2-opt", "Or-opt", "or-3opt"};
+    return names[m];
+}
+
+const char* lsTourName(lsTour r){
+    static const char* names[] = {"auto", "array", "list"};
+    return names[r];
+}
+
+double lsMovesPerSecond(const lsStats* stats, lsMove m){
+    // Postcondition: return the number of moves of type m evaluated per second spent in its neighbourhood
+    uint64_t cycles = 0;
+    for (int k=0; k<LS_NB_MOVES; k++) cycles += stats->cycles[k];
+    if (cycles == 0 || stats->cycles[m] == 0) return 0;
+    return stats->evaluated[m] / (stats->seconds * stats->cycles[m] / cycles);
+}
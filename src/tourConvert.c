@@ -0,0 +1,195 @@
+/*
+ Offline conversion of the tours written by tsp (see tourOutput.h) into a Python turtle script
+
+ Usage: tourConvert [-b] tours.bin|tours.csv [script.py]
+ Each tour of the file is drawn in turn (-b: only the best one), as the former print function of tsp
+ did during the search. Vertices without coordinates are placed on a circle.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <getopt.h>
+#include "tourOutput.h"
+
+void printPoints(int n, const double* xy, FILE* fd){
+    // side effect: print in fd the Python script defining the turtle coordinates of the vertices and of the label
+    fprintf(fd, "import turtle\n");
+    if (xy == NULL){
+        fprintf(fd, "turtle.setworldcoordinates(0, 0, 1000, 1100)\n");
+        for (int i=0; i<n; i++){
+            double angle = 2*acos(-1.0)*i / n;
+            fprintf(fd, "p%d=(%.0f,%.0f)\n", i, 500 + 450*cos(angle), 500 + 450*sin(angle));
+        }
+        fprintf(fd, "label=(0,1050)\n");
+        return;
+    }
+    double minX = xy[0], maxX = xy[0], minY = xy[1], maxY = xy[1];
+    for (int i=1; i<n; i++){
+        minX = fmin(minX, xy[2*i]);
+        maxX = fmax(maxX, xy[2*i]);
+        minY = fmin(minY, xy[2*i+1]);
+        maxY = fmax(maxY, xy[2*i+1]);
+    }
+    double margin = (maxY - minY) / 10;
+    fprintf(fd, "turtle.setworldcoordinates(%.17g, %.17g, %.17g, %.17g)\n", minX, minY, maxX, maxY + margin);
+    for (int i=0; i<n; i++) fprintf(fd, "p%d=(%.17g,%.17g)\n", i, xy[2*i], xy[2*i+1]);
+    fprintf(fd, "label=(%.17g,%.17g)\n", minX, maxY + margin/2);
+}
+
+void printTour(const int32_t* sol, int n, int totalLength, FILE* fd){
+    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]; fd = file descriptor
+    // side effect: print in fd the Python script for displaying the tour associated with sol
+    fprintf(fd, "turtle.clear()\n");
+    fprintf(fd, "turtle.tracer(0,0)\n");
+    fprintf(fd, "turtle.penup()\n");
+    fprintf(fd, "turtle.goto(label)\n");
+    fprintf(fd, "turtle.write(\"Total length = %d\")\n", totalLength);
+    fprintf(fd, "turtle.speed(0)\n");
+    fprintf(fd, "turtle.goto(p%d)\n", sol[0]);
+    fprintf(fd, "turtle.pendown()\n");
+    for (int i=1; i<n; i++) fprintf(fd, "turtle.goto(p%d)\n", sol[i]);
+    fprintf(fd, "turtle.goto(p%d)\n", sol[0]);
+    fprintf(fd, "turtle.update()\n");
+    fprintf(fd, "wait = input(\"Enter return to continue\")\n");
+}
+
+bool readBinaryHeader(FILE* in, int* n, double** xy){
+    // Postcondition: the header and the coordinates of a binary tour file are read
+    tourFileHeader h;
+    if (fread(&h, sizeof(h), 1, in) != 1 || memcmp(h.magic, TOUR_MAGIC, 4) != 0 || h.version != TOUR_VERSION || h.n < 1) return false;
+    *n = h.n;
+    *xy = NULL;
+    if (h.hasCoords){
+        *xy = (double*) malloc(2*(size_t)h.n*sizeof(double));
+        if (*xy == NULL || fread(*xy, sizeof(double), 2*(size_t)h.n, in) != 2*(size_t)h.n) return false;
+    }
+    return true;
+}
+
+bool readCsvHeader(FILE* in, int* n, double** xy){
+    // Postcondition: the "vertex,x,y" lines of a CSV tour file are read, up to the "length,tour" line
+    // (without coordinates, n is found from the first tour)
+    char line[64];
+    size_t capacity = 1024;
+    *n = 0;
+    *xy = NULL;
+    if (fgets(line, sizeof(line), in) == NULL) return false;
+    if (strncmp(line, "vertex,x,y", 10) == 0){
+        *xy = (double*) malloc(2*capacity*sizeof(double));
+        int i;
+        double x, y;
+        while (*xy != NULL && fscanf(in, "%d,%lf,%lf", &i, &x, &y) == 3){
+            if (i != *n) return false;
+            if ((size_t)*n == capacity){
+                capacity *= 2;
+                double* bigger = (double*) realloc(*xy, 2*capacity*sizeof(double));
+                if (bigger == NULL) return false;
+                *xy = bigger;
+            }
+            (*xy)[2*i] = x;
+            (*xy)[2*i+1] = y;
+            (*n)++;
+        }
+        if (*xy == NULL || fgets(line, sizeof(line), in) == NULL) return false;
+    }
+    return strncmp(line, "length,tour", 11) == 0;
+}
+
+bool readCsvTour(FILE* in, int* n, int32_t** record){
+    // Postcondition: the next "length,tour" line is read in record (length, then the tour); if n is 0, it is set
+    //                to the number of vertices of this tour
+    int length, v;
+    if (fscanf(in, "%d,", &length) != 1) return false;
+    size_t capacity = (*n > 0) ? (size_t)*n : 1024;
+    if (*record == NULL && (*record = (int32_t*) malloc((capacity+1)*sizeof(int32_t))) == NULL) return false;
+    (*record)[0] = length;
+    int k = 0;
+    for (int c = fgetc(in); c != '\n' && c != EOF; c = fgetc(in)){
+        if (c == ' ') continue;
+        ungetc(c, in);
+        if (fscanf(in, "%d", &v) != 1) return false;
+        if ((size_t)k == capacity){
+            if (*n > 0) return false; // longer than the number of vertices
+            capacity *= 2;
+            int32_t* bigger = (int32_t*) realloc(*record, (capacity+1)*sizeof(int32_t));
+            if (bigger == NULL) return false;
+            *record = bigger;
+        }
+        (*record)[++k] = v;
+    }
+    if (*n == 0) *n = k;
+    return k == *n;
+}
+
+int main(int argc, char** argv){
+    bool bestOnly = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "b")) != -1){
+        if (opt == 'b') bestOnly = true;
+        else {
+            printf("Usage: %s [-b] tours.bin|tours.csv [script.py]\n", argv[0]);
+            return 0;
+        }
+    }
+    if (optind >= argc){
+        printf("Usage: %s [-b] tours.bin|tours.csv [script.py]\n", argv[0]);
+        return 0;
+    }
+    const char* inPath = argv[optind];
+    const char* outPath = (optind+1 < argc) ? argv[optind+1] : "script.py";
+    size_t len = strlen(inPath);
+    bool csv = (len >= 4 && strcmp(inPath + len - 4, ".csv") == 0);
+    FILE* in = fopen(inPath, csv ? "r" : "rb");
+    if (in == NULL){
+        printf("Cannot open %s.\n", inPath);
+        return 0;
+    }
+    int n = 0;
+    double* xy = NULL;
+    if (!(csv ? readCsvHeader(in, &n, &xy) : readBinaryHeader(in, &n, &xy)) || (!csv && n <= 0)){
+        printf("%s is not a tour file.\n", inPath);
+        fclose(in);
+        free(xy);
+        return 0;
+    }
+    // in a csv file without coordinates, n is only known after the first tour
+    int32_t* record = (n > 0) ? (int32_t*) malloc((n+1)*sizeof(int32_t)) : NULL;
+    if (n > 0 && record == NULL){
+        printf("Not enough memory for %d vertices.\n", n);
+        fclose(in);
+        free(xy);
+        return 0;
+    }
+    FILE* fd = fopen(outPath, "w");
+    if (fd == NULL){
+        printf("Cannot create %s.\n", outPath);
+        fclose(in);
+        free(xy);
+        free(record);
+        return 0;
+    }
+    int32_t* best = NULL;
+    long nbTours = 0;
+    while (csv ? readCsvTour(in, &n, &record) : fread(record, sizeof(int32_t), n+1, in) == (size_t)n+1){
+        if (nbTours++ == 0) printPoints(n, xy, fd);
+        if (!bestOnly) printTour(record + 1, n, record[0], fd);
+        else if (best == NULL || record[0] < best[0]){
+            if (best == NULL && (best = (int32_t*) malloc((n+1)*sizeof(int32_t))) == NULL){
+                printf("Not enough memory for %d vertices.\n", n);
+                break;
+            }
+            memcpy(best, record, (n+1)*sizeof(int32_t));
+        }
+    }
+    if (best != NULL) printTour(best + 1, n, best[0], fd);
+    printf("%ld tours read from %s; %s written\n", nbTours, inPath, outPath);
+    fclose(in);
+    fclose(fd);
+    free(xy);
+    free(record);
+    free(best);
+    return 0;
+}
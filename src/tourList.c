@@ -0,0 +1,230 @@
+/*
+ Tour stored in a two-level doubly-linked list (Fredman, Johnson, McGeoch and Ostheimer)
+
+ A permutation sol[0..n-1] gives the successor of a vertex in O(1), but a 2-opt move reverses one
+ of the two paths it separates, which moves O(n) vertices. Here, the tour is cut into segments of
+ about sqrt(n) consecutive vertices. The vertices of a segment are linked in a stored order, with
+ consecutive sequence numbers, and the segment has a reversal bit telling whether the tour reads
+ them in this order or backwards; the segments are linked in the order of the tour, with their
+ rank in it. next and prev follow the links of the vertex, through its reversal bit, and jump to
+ the neighbouring segment at the ends; between compares the (rank, signed sequence number) keys.
+ A flip reverses the path from b to c:
+ - inside a segment, the vertices of the path are relinked in reverse order, in O(sqrt(n));
+ - otherwise, the segments of b and of the vertex after c are split, so that the path is made of
+   whole segments (the smaller part of a split segment moves to a new segment), and the order of
+   these segments is reversed and their reversal bits flipped, in O(number of segments).
+ The shorter side of the tour, in segments, is the one reversed. Splits only add segments, so the
+ list is rebuilt with segments of sqrt(n) vertices when a flip could run out of them: with room
+ for 4 times the initial number of segments, this costs O(n) every O(sqrt(n)) flips or more.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "tourList.h"
+
+static void build(tourList* l, const int* order){
+    // Postcondition: l is the tour order[0..n-1], cut into segments of groupSize vertices
+    int n = l->n, g = l->groupSize;
+    int m = (n + g - 1) / g;
+    for (int s=0; s<m; s++){
+        int from = s*g, to = (from + g < n) ? from + g : n;
+        for (int p=from; p<to; p++){
+            tourNode* x = &l->nodes[order[p]];
+            x->next = (p+1 < to) ? order[p+1] : -1;
+            x->prev = (p > from) ? order[p-1] : -1;
+            x->seq = p - from;
+            x->segment = s;
+        }
+        l->segments[s] = (tourSegment){.first = order[from], .last = order[to-1], .size = to - from,
+                                       .next = (s+1 < m) ? s+1 : 0, .prev = (s > 0) ? s-1 : m-1, .rank = s, .reversed = false};
+    }
+    l->nbSegments = m;
+}
+
+/**
+ * Two-level list of the tour sol
+ * Precondition: sol[0..n-1] is a permutation of [0,n-1], with n >= 1
+ * Return the list, or NULL if there is not enough memory
+ */
+tourList* tourListCreate(int n, const int* sol){
+    tourList* l = (tourList*) calloc(1, sizeof(tourList));
+    if (l == NULL) return NULL;
+    l->n = n;
+    l->groupSize = (int)sqrt(n);
+    if (l->groupSize < 1) l->groupSize = 1;
+    l->maxSegments = 4*((n + l->groupSize - 1) / l->groupSize) + 2;
+    l->nodes = (tourNode*) malloc(n*sizeof(tourNode));
+    l->segments = (tourSegment*) malloc(l->maxSegments*sizeof(tourSegment));
+    l->buffer = (int*) malloc(n*sizeof(int));
+    l->run = (int*) malloc(l->maxSegments*sizeof(int));
+    if (l->nodes == NULL || l->segments == NULL || l->buffer == NULL || l->run == NULL){
+        tourListFree(l);
+        return NULL;
+    }
+    build(l, sol);
+    return l;
+}
+
+void tourListFree(tourList* l){
+    if (l == NULL) return;
+    free(l->nodes);
+    free(l->segments);
+    free(l->buffer);
+    free(l->run);
+    free(l);
+}
+
+void tourListToArray(const tourList* l, int first, int* sol){
+    // Postcondition: sol[0..n-1] is the tour, starting from first
+    int v = first;
+    for (int p=0; p<l->n; p++, v = tourNext(l, v)) sol[p] = v;
+}
+
+static void rebuild(tourList* l){
+    // Postcondition: same tour, in segments of groupSize vertices
+    tourListToArray(l, l->segments[0].first, l->buffer);
+    build(l, l->buffer);
+    l->rebuilds++;
+}
+
+static void renumber(tourList* l){
+    // Postcondition: the ranks of the segments follow their order in the tour
+    int s = 0;
+    for (int r=0; r<l->nbSegments; r++, s = l->segments[s].next) l->segments[s].rank = r;
+}
+
+static inline int forwardOffset(const tourList* l, int v){
+    // Postcondition: return the number of vertices before v in its segment, in the direction of the tour
+    const tourSegment* s = &l->segments[l->nodes[v].segment];
+    return s->reversed ? l->nodes[s->last].seq - l->nodes[v].seq : l->nodes[v].seq - l->nodes[s->first].seq;
+}
+
+static void reverseInside(tourList* l, int b, int c){
+    // Precondition: b and c are in the same segment, b before c in the direction of the tour
+    // Postcondition: the path from b to c is reversed
+    int s = l->nodes[b].segment;
+    tourSegment* seg = &l->segments[s];
+    int x = seg->reversed ? c : b, y = seg->reversed ? b : c; // stored order x .. y
+    int before = l->nodes[x].prev, after = l->nodes[y].next, seq = l->nodes[x].seq;
+    int k = 0;
+    for (int v=x; ; v = l->nodes[v].next){
+        l->buffer[k++] = v;
+        if (v == y) break;
+    }
+    for (int i=0; i<k; i++){
+        tourNode* u = &l->nodes[l->buffer[k-1-i]];
+        u->seq = seq + i;
+        u->prev = (i == 0) ? before : l->buffer[k-i];
+        u->next = (i == k-1) ? after : l->buffer[k-2-i];
+    }
+    if (before >= 0) l->nodes[before].next = y;
+    else seg->first = y;
+    if (after >= 0) l->nodes[after].prev = x;
+    else seg->last = x;
+}
+
+static void split(tourList* l, int v){
+    // Precondition: nbSegments < maxSegments
+    // Postcondition: v is the first vertex of its segment in the direction of the tour (the ranks may be stale)
+    int s = l->nodes[v].segment;
+    tourSegment* seg = &l->segments[s];
+    int head = forwardOffset(l, v); // vertices before v in the segment
+    if (head == 0) return;
+    int tail = seg->size - head;    // v and the vertices after it
+    bool moveTail = (tail <= head);
+    int first = moveTail ? v : (seg->reversed ? seg->last : seg->first);
+    int k = moveTail ? tail : head;
+    // the vertices that move, in the direction of the tour
+    for (int i=0, u=first; i<k; i++, u = seg->reversed ? l->nodes[u].prev : l->nodes[u].next) l->buffer[i] = u;
+    int last = l->buffer[k-1];
+    if (moveTail == seg->reversed){
+        // the part that moves is at the start of the stored order
+        seg->first = moveTail ? l->nodes[v].next : l->nodes[last].next;
+        l->nodes[seg->first].prev = -1;
+    } else {
+        seg->last = moveTail ? l->nodes[v].prev : l->nodes[last].prev;
+        l->nodes[seg->last].next = -1;
+    }
+    seg->size -= k;
+
+    int t = l->nbSegments++;
+    for (int i=0; i<k; i++){
+        tourNode* u = &l->nodes[l->buffer[i]];
+        u->seq = i;
+        u->prev = (i > 0) ? l->buffer[i-1] : -1;
+        u->next = (i < k-1) ? l->buffer[i+1] : -1;
+        u->segment = t;
+    }
+    tourSegment* nt = &l->segments[t];
+    *nt = (tourSegment){.first = l->buffer[0], .last = last, .size = k, .reversed = false};
+    seg = &l->segments[s];
+    if (moveTail){ // t follows s
+        nt->next = seg->next;
+        nt->prev = s;
+        l->segments[seg->next].prev = t;
+        seg->next = t;
+    } else {       // t precedes s
+        nt->prev = seg->prev;
+        nt->next = s;
+        l->segments[seg->prev].next = t;
+        seg->prev = t;
+    }
+    l->splits++;
+}
+
+static void reversePath(tourList* l, int b, int c){
+    // Postcondition: the path from b to c, in the direction of the tour, is reversed
+    if (b == c) return;
+    int d = tourNext(l, c), a = tourPrev(l, b);
+    if (d == b) return; // the whole tour: only its direction would change
+    int sb = l->nodes[b].segment, sc = l->nodes[c].segment;
+    if (sb == sc){
+        // either the path or the rest of the tour is inside the segment
+        if (forwardOffset(l, b) <= forwardOffset(l, c)) reverseInside(l, b, c);
+        else reverseInside(l, d, a);
+        return;
+    }
+    int nb = l->nbSegments;
+    int pathSegments = (l->segments[sc].rank - l->segments[sb].rank + nb) % nb;
+    int restSegments = (l->segments[l->nodes[a].segment].rank - l->segments[l->nodes[d].segment].rank + nb) % nb;
+    if (restSegments < pathSegments){
+        // reversing the rest of the tour gives the same edges
+        reversePath(l, d, a);
+        return;
+    }
+    if (l->nbSegments + 2 > l->maxSegments){
+        rebuild(l);
+        reversePath(l, b, c);
+        return;
+    }
+    split(l, b);
+    split(l, d);
+    // the path is now made of the whole segments from the segment of b to the segment of c
+    int k = 0;
+    for (int s = l->nodes[b].segment; ; s = l->segments[s].next){
+        l->run[k++] = s;
+        if (s == l->nodes[c].segment) break;
+    }
+    int before = l->segments[l->run[0]].prev, after = l->segments[l->run[k-1]].next;
+    for (int i=0; i<k; i++){
+        tourSegment* s = &l->segments[l->run[i]];
+        s->reversed = !s->reversed;
+        s->next = (i == 0) ? after : l->run[i-1];
+        s->prev = (i == k-1) ? before : l->run[i+1];
+    }
+    l->segments[before].next = l->run[k-1];
+    l->segments[after].prev = l->run[0];
+    renumber(l);
+}
+
+/**
+ * 2-opt move
+ * Precondition: (a,b) and (c,d) are edges of the tour, and b follows a in the same direction as d follows c
+ * Postcondition: they are replaced by (a,c) and (b,d); the direction of the tour may change
+ */
+void tourFlip(tourList* l, int a, int b, int c, int d){
+    if (b == c || a == d) return; // the edges are already (a,c) and (b,d)
+    if (tourNext(l, a) == b) reversePath(l, b, c);
+    else reversePath(l, c, b);
+    l->flips++;
+}
@@ -0,0 +1,189 @@
+/*
+ Output of the tours found by the solvers, off the hot path
+
+ outputTour never calls stdio. In OUTPUT_BEST mode it only copies a tour that is better than the
+ best one so far. In OUTPUT_STREAM mode it appends the record (length, tour) to one of two large
+ buffers; when that buffer is full, the buffers are swapped and a background thread writes the
+ full one, formatting it as CSV if needed, while the solver fills the other. If the writer is still
+ busy when the second buffer fills up, the record is dropped (and counted) rather than waiting.
+ The turtle script of the former print function is now produced offline by tourConvert.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include "tourOutput.h"
+
+#define BUFFER_BYTES ((size_t)16 << 20)
+
+static void writeRecords(tourOutput* out, const char* records, size_t bytes){
+    // Postcondition: the records of records[0..bytes-1] are written in out->file
+    if (out->format == FORMAT_BINARY){
+        fwrite(records, 1, bytes, out->file);
+    } else {
+        for (size_t r=0; r<bytes; r += out->recordBytes){
+            const int32_t* record = (const int32_t*)(records + r);
+            fprintf(out->file, "%d,", record[0]);
+            for (int i=0; i<out->n; i++) fprintf(out->file, i == 0 ? "%d" : " %d", record[i+1]);
+            fprintf(out->file, "\n");
+        }
+    }
+    out->written += bytes / out->recordBytes;
+}
+
+static void* writerThread(void* arg){
+    tourOutput* out = (tourOutput*) arg;
+    pthread_mutex_lock(&out->lock);
+    while (true){
+        while (!out->pending && !out->closing) pthread_cond_wait(&out->ready, &out->lock);
+        if (!out->pending) break; // closing, and nothing left to write in the other buffer
+        int b = 1 - out->filling;
+        pthread_mutex_unlock(&out->lock);
+        // the solver does not touch buffer b while pending is set
+        writeRecords(out, out->buffers[b], out->used[b]);
+        out->used[b] = 0;
+        pthread_mutex_lock(&out->lock);
+        out->pending = false;
+    }
+    pthread_mutex_unlock(&out->lock);
+    return NULL;
+}
+
+static void writeHeader(tourOutput* out, const double* xy){
+    if (out->format == FORMAT_BINARY){
+        tourFileHeader h = {.version = TOUR_VERSION, .n = out->n, .hasCoords = (xy != NULL)};
+        memcpy(h.magic, TOUR_MAGIC, 4);
+        fwrite(&h, sizeof(h), 1, out->file);
+        if (xy != NULL) fwrite(xy, sizeof(double), 2*(size_t)out->n, out->file);
+    } else {
+        if (xy != NULL){
+            fprintf(out->file, "vertex,x,y\n");
+            for (int i=0; i<out->n; i++) fprintf(out->file, "%d,%.17g,%.17g\n", i, xy[2*i], xy[2*i+1]);
+        }
+        fprintf(out->file, "length,tour\n");
+    }
+}
+
+/**
+ * Open the output of the tours of an instance of n vertices in file path, in the given mode
+ * The format is CSV if path ends with .csv, binary otherwise. The coordinates xy[0..2n-1], if not NULL,
+ * are written first, so that the file can be displayed on its own.
+ * Return NULL if the file cannot be created or if there is not enough memory (OUTPUT_OFF never fails)
+ */
+tourOutput* outputOpen(const char* path, outputMode mode, int n, const double* xy){
+    tourOutput* out = (tourOutput*) calloc(1, sizeof(tourOutput));
+    if (out == NULL) return NULL;
+    out->mode = mode;
+    out->n = n;
+    out->recordBytes = (size_t)(n+1)*sizeof(int32_t);
+    pthread_mutex_init(&out->lock, NULL);
+    pthread_cond_init(&out->ready, NULL);
+    if (mode == OUTPUT_OFF) return out;
+    size_t len = strlen(path);
+    out->format = (len >= 4 && strcmp(path + len - 4, ".csv") == 0) ? FORMAT_CSV : FORMAT_BINARY;
+    out->file = fopen(path, out->format == FORMAT_CSV ? "w" : "wb");
+    if (out->file == NULL){
+        out->mode = OUTPUT_OFF;
+        outputClose(out);
+        return NULL;
+    }
+    writeHeader(out, xy);
+    if (mode == OUTPUT_BEST){
+        out->best = (int32_t*) malloc(out->recordBytes);
+        if (out->best == NULL){
+            outputClose(out);
+            return NULL;
+        }
+        out->best[0] = -1;
+        return out;
+    }
+    out->capacity = (BUFFER_BYTES > 2*out->recordBytes) ? BUFFER_BYTES : 2*out->recordBytes;
+    out->buffers[0] = (char*) malloc(out->capacity);
+    out->buffers[1] = (char*) malloc(out->capacity);
+    if (out->buffers[0] == NULL || out->buffers[1] == NULL || pthread_create(&out->writer, NULL, writerThread, out) != 0){
+        free(out->buffers[0]);
+        free(out->buffers[1]);
+        out->buffers[0] = out->buffers[1] = NULL;
+        out->mode = OUTPUT_OFF; // no thread to join, nor tour to write
+        outputClose(out);
+        return NULL;
+    }
+    return out;
+}
+
+/**
+ * Record the tour sol[0..n-1] of length length
+ * Never waits for the file: may be called from the solver loops, by several threads at once in OUTPUT_STREAM mode
+ */
+void outputTour(tourOutput* out, const int* sol, int length){
+    if (out == NULL || out->mode == OUTPUT_OFF) return;
+    if (out->mode == OUTPUT_BEST){
+        if (out->best[0] < 0 || length < out->best[0]){
+            out->best[0] = length;
+            memcpy(out->best + 1, sol, out->n*sizeof(int32_t));
+        }
+        return;
+    }
+    pthread_mutex_lock(&out->lock);
+    if (out->used[out->filling] + out->recordBytes > out->capacity){
+        if (out->pending){
+            out->dropped++;
+            pthread_mutex_unlock(&out->lock);
+            return;
+        }
+        out->filling = 1 - out->filling;
+        out->pending = true;
+        pthread_cond_signal(&out->ready);
+    }
+    int32_t* record = (int32_t*)(out->buffers[out->filling] + out->used[out->filling]);
+    record[0] = length;
+    memcpy(record + 1, sol, out->n*sizeof(int32_t));
+    out->used[out->filling] += out->recordBytes;
+    pthread_mutex_unlock(&out->lock);
+}
+
+/**
+ * Write the tours not written yet, and close the output
+ */
+void outputClose(tourOutput* out){
+    if (out == NULL) return;
+    if (out->mode == OUTPUT_BEST && out->best != NULL && out->best[0] >= 0) writeRecords(out, (const char*)out->best, out->recordBytes);
+    if (out->mode == OUTPUT_STREAM){
+        pthread_mutex_lock(&out->lock);
+        out->closing = true;
+        pthread_cond_signal(&out->ready);
+        pthread_mutex_unlock(&out->lock);
+        pthread_join(out->writer, NULL);
+        writeRecords(out, out->buffers[out->filling], out->used[out->filling]);
+        if (out->dropped > 0)
+            fprintf(stderr, "%lu tours were not written, as the writer could not keep up.\n", (unsigned long)out->dropped);
+    }
+    pthread_mutex_destroy(&out->lock);
+    pthread_cond_destroy(&out->ready);
+    if (out->file != NULL) fclose(out->file);
+    free(out->best);
+    free(out->buffers[0]);
+    free(out->buffers[1]);
+    free(out);
+}
+
+/**
+ * Parse an output specification off, best[:file] or stream[:file]
+ * (by default, the best tour goes to tours.csv and the stream to tours.bin)
+ * Return false if spec is not one of them
+ */
+bool outputParse(const char* spec, outputMode* mode, const char** path){
+    const char* colon = strchr(spec, ':');
+    size_t len = (colon != NULL) ? (size_t)(colon - spec) : strlen(spec);
+    if (len == 3 && strncmp(spec, "off", 3) == 0 && colon == NULL){
+        *mode = OUTPUT_OFF;
+        *path = NULL;
+    } else if (len == 4 && strncmp(spec, "best", 4) == 0){
+        *mode = OUTPUT_BEST;
+        *path = (colon != NULL) ? colon+1 : "tours.csv";
+    } else if (len == 6 && strncmp(spec, "stream", 6) == 0){
+        *mode = OUTPUT_STREAM;
+        *path = (colon != NULL) ? colon+1 : "tours.bin";
+    } else return false;
+    return *path == NULL || **path != '\0';
+}
@@ -3,7 +3,7 @@
  Copyright (C) 2023 Christine Solnon
  Ce programme est un logiciel libre ; vous pouvez le redistribuer et/ou le modifier au titre des clauses de la Licence Publique Générale GNU, telle que publiée par la Free Software Foundation. Ce programme est distribué dans l'espoir qu'il sera utile, mais SANS AUCUNE GARANTIE ; sans même une garantie implicite de COMMERCIABILITE ou DE CONFORMITE A UNE UTILISATION PARTICULIERE. Voir la Licence Publique Générale GNU pour plus de détails.
  
- Compile with: gcc -o tspls tsp.c -O3 -Wall -lm
+ Compile with: gcc -o tspls tsp.c localSearch.c -I ../inc -O3 -Wall -lm
  */
 
 #include <math.h>
@@ -14,6 +14,16 @@
 #include <unistd.h>
 #include <time.h>
 #include <stdbool.h>
+#include <getopt.h>
+#include "localSearch.h"
+#include "neighbourLS.h"
+#include "multiStart.h"
+#include "ils.h"
+#include "windowLS.h"
+#include "balasSimonetti.h"
+#include "tsplib.h"
+#include "tourOutput.h"
+#include "instrument.h"
 
 int iseed = 1;
 
@@ -25,46 +35,51 @@ int nextRand(int n){
     return iseed % n;
 }
 
-int** createCost(int n, FILE* fd){
-    // input: the number n of vertices and a file descriptor fd
-    // return a symmetrical cost matrix such that, for each i,j in [0,n-1], cost[i][j] = cost of arc (i,j)
-    // side effect: print in fd a Python script for defining turtle coordinates associated with vertices
-    int x[n], y[n];
+costProvider* createCost(int n, costKind kind){
+    // input: the number n of vertices, and the kind of storage of the costs (see costProvider.h)
+    // return the symmetrical costs of n random vertices, such that the cost of arc (i,j) is costOf(cost, i, j)
+    // (their coordinates are kept in cost->xy, for the output of the tours)
+    double* xy = (double*) malloc(2*(size_t)n*sizeof(double));
     int max = 1000;
-    int** cost;
     int iseed = 1;
 
-    // Allocate 1st dimension of cost
-    cost = (int**) malloc(n*sizeof(int*));
-
-    fprintf(fd, "import turtle\n");
-    fprintf(fd, "turtle.setworldcoordinates(0, 0, %d, %d)\n", max, max+100);
-    
-    // Init coordinates and allocate 2nd dimension of cost
+    // Init coordinates
     for (int i=0; i<n; i++){
-        x[i] = nextRand(max);
-        y[i] = nextRand(max);
-        fprintf(fd, "p%d=(%d,%d)\n", i, x[i], y[i]);
-        cost[i] = (int*)malloc(n*sizeof(int));
+        int x = nextRand(max);
+        int y = nextRand(max);
+        xy[2*i] = x;
+        xy[2*i+1] = y;
     }
 
-    // Fill cost matrix by computing euclidean distances
-    // between all pairs of vertices
-    // and set the diagonal to a large value
-    for (int i=0; i<n; i++){
-        cost[i][i] = max*max;
-        for (int j=i+1; j<n; j++){
-            cost[i][j] = (int)sqrt((x[i]-x[j])*(x[i]-x[j]) + (y[i]-y[j])*(y[i]-y[j]));
-            cost[j][i] = cost[i][j];
-        }
-    }
+    // euclidean distances between all pairs of vertices, computed once or on demand
+    costProvider* cost = costFromPoints(n, xy, METRIC_TRUNC_2D, kind);
+    free(xy);
+    return cost;
+}
+
+costProvider* loadInstance(const char* path, costKind kind, int* n){
+    // input: the path of a TSPLIB instance, and the kind of storage of the costs (see costProvider.h)
+    // output: n is the number of vertices of the instance
+    // return its costs, or NULL if it cannot be loaded (the reason is printed on stderr)
+    tsplibInstance* inst = tsplibLoad(path);
+    if (inst == NULL) return NULL;
+    *n = inst->n;
+    costProvider* cost = tsplibCost(inst, kind);
+    tsplibFree(inst);
     return cost;
 }
 
-int generateRandomTour(int n, int** cost, int seed, int* sol){
-    // input: the number of vertices n, the cost matrix such that for all i,j in [0,n-1], cost[i][j] = cost of arc (i,j), the seed for the random number generator
+int optimum = -1; // length of an optimal tour of the instance, when it is known
+
+void printGap(double length){
+    // side effect: print the gap between length and the optimal length, when it is known
+    if (optimum > 0) printf("    - Gap to the optimum (%d) = %.2f%%\n", optimum, 100.0*(length - optimum)/optimum);
+}
+
+int generateRandomTour(int n, const costProvider* cost, int seed, int* sol){
+    // input: the number of vertices n, the costs such that for all i,j in [0,n-1], costOf(cost, i, j) = cost of arc (i,j), the seed for the random number generator
     // output: sol[0..n-1] is a random permutation of [0..n-1]
-    // postcondition: return cost[n-1][0] + the sum of cost[i][i+1] for i in [0,n-2]
+    // postcondition: return the cost of (n-1,0) + the sum of the costs of (i,i+1) for i in [0,n-2]
     int cand[n]; // candidates for the next vertex
     for (int i=0; i<n; i++) cand[i] = i;
     sol[0] = nextRand(n); // randomly choose the first vertex
@@ -77,199 +92,12 @@ int generateRandomTour(int n, int** cost, int seed, int* sol){
         int j = nextRand(nbCand);
         sol[i] = cand[j];
         cand[j] = cand[--nbCand]; // remove the chosen candidate, replace it by another (unvisited) candidate
-        total += cost[sol[i-1]][sol[i]];
-    }
-    total += cost[sol[n-1]][sol[0]]; // don't forget the return to the depot
-    return total;
-}
-
-void print(int* sol, int n, int totalLength, FILE* fd){
-    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]; fd = file descriptor
-    // side effect: print in fd the Python script for displaying the tour associated with sol
-    fprintf(fd, "turtle.clear()\n");
-    fprintf(fd, "turtle.tracer(0,0)\n");
-    fprintf(fd, "turtle.penup()\n");
-    fprintf(fd, "turtle.goto(0,%d)\n", 1050);
-    fprintf(fd, "turtle.write(\"Total length = %d\")\n", totalLength);
-    fprintf(fd, "turtle.speed(0)\n");
-    fprintf(fd, "turtle.goto(p%d)\n", sol[0]);
-    fprintf(fd, "turtle.pendown()\n");
-    for (int i=1; i<n; i++) fprintf(fd, "turtle.goto(p%d)\n", sol[i]);
-    fprintf(fd, "turtle.goto(p%d)\n", sol[0]);
-    fprintf(fd, "turtle.update()\n");
-    fprintf(fd, "wait = input(\"Enter return to continue\")\n");
-}
-
-/**
- * Check if the edges (node0->node1) and (nodeLast->nodeNew) "cross"
- */
-bool isCrossing(
-    int node0, // v_i
-    int node1, // v{i+1}
-    int nodeLast, // v_j
-    int nodeNew, // v{j+1}
-    int** cost
-) {
-    /* check each edge before the last one
-
-    Example:
-    ╎     ╎
-    Ⓝ◁---①
-    ╎◸   ◹╎
-    ╎ ╲ ╱ ╎
-    ╎  ╳  ╎
-    ╎ ╱ ╲ ╎
-    ╎╱   ╲╎
-    ⓪---▷Ⓛ
-    ╎     ╎
-    We check that any edge (⓪->① + Ⓛ->Ⓝ) <= (⓪->Ⓛ + ①->Ⓝ)
-    */
-    // cost Ⓛ->Ⓝ
-    int costLastToNew = cost[nodeLast][nodeNew];
-    // cost ⓪->①
-    int cost0to1 = cost[node0][node1];
-    // cost ⓪->Ⓛ
-    int cost0toLast = cost[node0][nodeLast];
-    // cost ①->Ⓝ
-    int cost1toNew = cost[node1][nodeNew];
-    if (
-        (cost0toLast + cost1toNew) // cost ⓪->Ⓛ + ①->Ⓝ
-        < (cost0to1 + costLastToNew) // cost ⓪->① + Ⓛ->Ⓝ
-    ) {
-        return true;
-    } else {
-        return false;
-    }
-}
-
-bool is_2opt(int v_i0, int v_i1, int v_j0, int v_j1, int** cost){
-    int oldCost = cost[v_i0][v_i1] + cost[v_j0][v_j1];
-    int newCost = cost[v_i0][v_j0] + cost[v_i1][v_j1];
-    if (newCost < oldCost) {
-        return true; // the two edges cross
-    } else {
-        return false; // the two edges do not cross
-    }
-}
-
-void swap(int* sol, int i, int j){
-    // input: sol[0..n-1] = permutation of [0,n-1]; i,j = indices of two vertices in sol
-    // side effect: swap the two vertices in sol
-    int tmp = sol[i];
-    sol[i] = sol[j];
-    sol[j] = tmp;
-}
-
-bool while_procedure(int n, int* sol, int total, int** cost){
-    int v_i0 = 0;
-    int v_i1 = 0;
-    int v_j0 = 0;
-    int v_j1 = 0;
-    for (int i=0; i<n-1; i++) {
-        for (int j=i+2; j<n; j++) {
-            v_i0 = sol[i];
-            v_i1 = sol[i+1];
-            v_j0 = sol[j];
-            if (j == n-1) 
-                v_j1 = sol[0];
-            else
-                v_j1 = sol[j+1];
-            
-            //if (is_2opt(v_i0, v_i1, v_j0, v_j1, cost)) {
-            if (isCrossing(v_i0, v_i1, v_j0, v_j1, cost)) {
-                // swap arcs (v_i0->v_i1), (v_j0->v_j1) with (v_i0->v_j0), (v_i1->v_j1)
-                // To do that, we swap v_j0 and v_i1
-                // as we swap two by two any intermediate vertices
-                // between v_i1 and v_j0
-                int nb_swaps = ceil((j-i)/2.0);
-                for (int k=0; k<nb_swaps; k++) {
-                    swap(sol, i+1+k, j-k);
-                }
-                return true; // crossing detected
-            }
-        }
+        total += costOf(cost, sol[i-1], sol[i]);
     }
-    return false; // no crossing detected
-}
-
-void print_sol(int* sol, int n){
-    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]
-    // side effect: print the tour associated with sol
-    printf("Tour: ");
-    for (int i=0; i<n; i++) {
-        printf("%d ", sol[i]);
-    }
-    printf("\n");
-}
-
-int compute_sol_length(int* sol, int n, int** cost){
-    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]
-    // return the length of the tour associated with sol
-    int total = 0;
-    for (int i=0; i<n-1; i++) {
-        total += cost[sol[i]][sol[i+1]];
-    }
-    total += cost[sol[n-1]][sol[0]]; // don't forget the return to the depot
-    return total;
-}
-
-void print_sol_with_cost(int* sol, int n, int** cost){
-    // input: n = number n of vertices; sol[0..n-1] = permutation of [0,n-1]; total = length of the tour associated with sol
-    // side effect: print the tour associated with sol and its length
-    printf("Tour: ");
-    for (int i=0; i<n; i++) {
-        printf("%d ", sol[i]);
-    }
-    printf(" - Total length = %d\n", compute_sol_length(sol, n, cost));
-}
-
-int greedyLS(int n, int* sol, int total, int** cost){
-    // Input: sol[0..n-1] contains a permutation of [0,n-1], and total = length of the tour associated with sol
-    // Output: sol[0..n-1] contains a permutation of [Ø,n-1] such that the corresponding tour does not have crossing edges
-    // Return the length of the tour associated with sol
-    bool has_crossing;
-    while (true){
-        #ifdef DEBUG
-        print_sol_with_cost(sol, n, cost);
-        #endif
-        has_crossing = while_procedure(n, sol, total, cost);
-        if (!has_crossing) break;
-    }
-
-    return compute_sol_length(sol, n, cost);
-}
-
-int greedyLS2(int n, int* sol, int total, int** cost){
-    int bestImprovement, ibest, jbest;
-    do{
-        bestImprovement = 0;
-        for (int i=0; i<n-1; i++){
-            for (int j=i+1; j<n; j++){
-                int jplus1 = (j+1)%n;
-                int oldCost = cost[sol[i]][sol[i+1]] + cost[sol[j]][sol[jplus1]];
-                int newCost = cost[sol[i]][sol[j]] + cost[sol[i+1]][sol[jplus1]];
-                if (newCost - oldCost < bestImprovement){
-                    bestImprovement = newCost - oldCost;
-                    ibest = i;
-                    jbest = j;
-                }
-            }
-        }
-        if (bestImprovement < 0){
-            total += bestImprovement;
-            ibest++;
-            while (ibest < jbest){
-                int aux = sol[ibest];
-                sol[ibest] = sol[jbest];
-                sol[jbest] = aux;
-                ibest++; jbest--;
-            }
-        }
-    } while (bestImprovement < 0);
+    total += costOf(cost, sol[n-1], sol[0]); // don't forget the return to the depot
     return total;
 }
 
-
 /**
  * Iterative Greedy Local Search
  * 
@@ -279,12 +107,12 @@ int iterative_greedy_LS(
     int n, 
     int* sol, 
     int total, 
-    int** cost, 
+    const costProvider* cost, 
     int nb_iterations,
     int nb_perturbations
 ) {
     // Get initial solution
-    int UB = greedyLS(n, sol, total, cost);
+    int UB = greedyLS(n, sol, total, cost, NULL);
     int new_sol[n];
     
     for (int i=0; i<nb_iterations; i++) {
@@ -299,9 +127,9 @@ int iterative_greedy_LS(
                 rand_index_1 = nextRand(n);
                 rand_index_2 = nextRand(n);
             } while (rand_index_1 == rand_index_2);
-            swap(sol, rand_index_1, rand_index_2);
+            swap(new_sol, rand_index_1, rand_index_2);
         }
-        int new_length = greedyLS(n, new_sol, total, cost);
+        int new_length = greedyLS(n, new_sol, compute_sol_length(new_sol, n, cost), cost, NULL);
         if (new_length < UB) {
             // Update the best solution
             UB = new_length;
@@ -314,27 +142,465 @@ int iterative_greedy_LS(
     return UB;
 }
 
+/**
+ * Compare greedyLS2 with the candidate-list 2-opt engine on the same random tours
+ */
+void compareNeighbourLS(int n, const costProvider* cost, int nb_iterations, int k, int moves, bool reference, tourOutput* out){
+    clock_t t = clock();
+    candidateLists* cand = candidatesCreate(n, cost, k);
+    if (cand == NULL){
+        printf("Not enough memory for the candidate lists.\n");
+        return;
+    }
+    printf("Candidate lists (k = %d): CPU time = %.3fs\n", cand->k, ((double) (clock() - t)) / CLOCKS_PER_SEC);
+    int* sol = (int*) malloc(n*sizeof(int));
+    int* sol2 = (int*) malloc(n*sizeof(int));
+    double timeLS2 = 0, timeNL = 0;
+    long long lengthLS2 = 0, lengthNL = 0;
+    lsStats stats, sum = {0};
+    iseed = 1; // reset the random number generator
+    for (int i=0; i<nb_iterations; i++){
+        int total = generateRandomTour(n, cost, i, sol);
+        printf("Trial %d: Initial tour length = %d; ", i, total);
+        if (reference){
+            memcpy(sol2, sol, n*sizeof(int));
+            t = clock();
+            int d = greedyLS2(n, sol2, total, cost, NULL);
+            double duration = ((double) (clock() - t)) / CLOCKS_PER_SEC;
+            timeLS2 += duration;
+            lengthLS2 += d;
+            printf("greedyLS2 = %d (%.3fs); ", d, duration);
+        }
+        t = clock();
+        total = neighbourLS(n, sol, total, cost, cand, moves, &stats);
+        double duration = ((double) (clock() - t)) / CLOCKS_PER_SEC;
+        timeNL += duration;
+        lengthNL += total;
+        for (int m=0; m<LS_NB_MOVES; m++){
+            sum.evaluated[m] += stats.evaluated[m];
+            sum.applied[m] += stats.applied[m];
+            sum.cycles[m] += stats.cycles[m];
+        }
+        sum.seconds += stats.seconds;
+        printf("neighbourLS = %d (%.3fs)\n", total, duration);
+        outputTour(out, sol, total);
+    }
+    for (int m=0; m<LS_NB_MOVES; m++){
+        if (!(moves & LS_MOVE_BIT(m))) continue;
+        printf("%-8s evaluated = %12lu; applied = %9lu; evaluated/s = %.3g\n", lsMoveName(m),
+               (unsigned long)sum.evaluated[m], (unsigned long)sum.applied[m], lsMovesPerSecond(&sum, m));
+    }
+    printf("Average tour length: neighbourLS = %.1f", (double)lengthNL/nb_iterations);
+    if (reference && nb_iterations > 0)
+        printf("; greedyLS2 = %.1f (%+.2f%%); speedup = %.1f",
+               (double)lengthLS2/nb_iterations, 100.0*(lengthNL - lengthLS2)/lengthLS2, timeNL > 0 ? timeLS2/timeNL : 0);
+    printf("\n");
+    if (nb_iterations > 0) printGap((double)lengthNL/nb_iterations);
+    free(sol);
+    free(sol2);
+    candidatesFree(cand);
+}
+
+/**
+ * Run the restarts on 1 thread, then on nbThreads threads, and compare their throughput and best tours
+ */
+void compareMultiStart(int n, const costProvider* cost, int nb_iterations, int k, int moves, int nbThreads, uint64_t seed, tourOutput* out){
+    candidateLists* cand = NULL;
+    if (k > 0 && (cand = candidatesCreate(n, cost, k)) == NULL){
+        printf("Not enough memory for the candidate lists.\n");
+        return;
+    }
+    int* best = (int*) malloc(n*sizeof(int));
+    int restartsDone[nbThreads];
+    msStats serial = {0}, parallel = {0};
+    parallel.restartsDone = restartsDone;
+    int ds = multiStartLS(n, cost, cand, moves, nb_iterations, 1, seed, best, &serial);
+    int dp = multiStartLS(n, cost, cand, moves, nb_iterations, nbThreads, seed, best, &parallel);
+    if (ds < 0 || dp < 0) printf("Not enough memory for the restarts.\n");
+    else {
+        printf("%s, %d restarts, seed %lu\n", cand == NULL ? "greedyLS2" : "neighbourLS", nb_iterations, (unsigned long)seed);
+        printf("1 thread:   best length = %d (restart %d); wall time = %.3fs; %.1f restarts/s\n",
+               ds, serial.bestRestart, serial.seconds, nb_iterations/serial.seconds);
+        printf("%d threads: best length = %d (restart %d); wall time = %.3fs; %.1f restarts/s; speedup = %.2f\n",
+               nbThreads, dp, parallel.bestRestart, parallel.seconds, nb_iterations/parallel.seconds, serial.seconds/parallel.seconds);
+        printf("Restarts per thread:");
+        for (int w=0; w<nbThreads; w++) printf(" %d", restartsDone[w]);
+        printf("\n");
+        if (ds != dp || serial.bestRestart != parallel.bestRestart) printf("    - MISMATCH between the serial and the parallel runs\n");
+        printGap(dp);
+        outputTour(out, best, dp);
+    }
+    free(best);
+    candidatesFree(cand);
+}
+
+/**
+ * Re-optimise the greedyLS2 tours with exact DP on windows of k consecutive vertices
+ */
+void compareWindowLS(int n, const costProvider* cost, int nb_iterations, int k, int nbThreads, tourOutput* out){
+    int* sol = (int*) malloc(n*sizeof(int));
+    long long lengthLS2 = 0, lengthW = 0;
+    double timeLS2 = 0, timeW = 0;
+    iseed = 1; // reset the random number generator
+    for (int i=0; i<nb_iterations; i++){
+        int total = generateRandomTour(n, cost, i, sol);
+        printf("Trial %d: Initial tour length = %d; ", i, total);
+        double t = wallTime();
+        total = greedyLS2(n, sol, total, cost, NULL);
+        t = wallTime() - t;
+        timeLS2 += t;
+        lengthLS2 += total;
+        printf("greedyLS2 = %d (%.3fs); ", total, t);
+        windowStats stats;
+        total = windowLS(n, sol, total, cost, k, nbThreads, &stats);
+        if (total < 0){
+            printf("\nNot enough memory for the window tables.\n");
+            free(sol);
+            return;
+        }
+        timeW += stats.seconds;
+        lengthW += total;
+        printf("windows = %d (%.3fs; %d passes; %ld of %ld windows improved)%s\n", total, stats.seconds, stats.passes,
+               stats.improved, stats.windows, total != compute_sol_length(sol, n, cost) ? "  MISMATCH" : "");
+        outputTour(out, sol, total);
+    }
+    if (nb_iterations > 0){
+        printf("Average tour length: greedyLS2 = %.1f (%.3fs); with windows of %d vertices = %.1f (%+.2f%%; %.3fs on %d threads)\n",
+               (double)lengthLS2/nb_iterations, timeLS2/nb_iterations, k, (double)lengthW/nb_iterations,
+               100.0*(lengthW - lengthLS2)/lengthLS2, timeW/nb_iterations, nbThreads > 0 ? nbThreads : 1);
+        printGap((double)lengthW/nb_iterations);
+    }
+    free(sol);
+}
+
+/**
+ * Improve the greedyLS2 tours with the Balas-Simonetti neighbourhood of width k
+ */
+void compareBalasSimonetti(int n, const costProvider* cost, int nb_iterations, int k, tourOutput* out){
+    int* sol = (int*) malloc(n*sizeof(int));
+    bsTable* table = bsCreate(n, k);
+    if (sol == NULL || table == NULL){
+        printf("Not enough memory for the Balas-Simonetti table.\n");
+        free(sol);
+        bsFree(table);
+        return;
+    }
+    long long lengthLS2 = 0, lengthBS = 0;
+    double timeLS2 = 0, timeBS = 0;
+    iseed = 1; // reset the random number generator
+    for (int i=0; i<nb_iterations; i++){
+        int total = generateRandomTour(n, cost, i, sol);
+        printf("Trial %d: Initial tour length = %d; ", i, total);
+        double t = wallTime();
+        total = greedyLS2(n, sol, total, cost, NULL);
+        t = wallTime() - t;
+        timeLS2 += t;
+        lengthLS2 += total;
+        printf("greedyLS2 = %d (%.3fs); ", total, t);
+        bsStats stats;
+        total = balasSimonettiLS(table, sol, total, cost, &stats);
+        timeBS += stats.seconds;
+        lengthBS += total;
+        printf("Balas-Simonetti = %d (%.3fs; %d of %d steps improved)%s\n", total, stats.seconds, stats.improvements,
+               stats.steps, total != compute_sol_length(sol, n, cost) ? "  MISMATCH" : "");
+        outputTour(out, sol, total);
+    }
+    if (nb_iterations > 0){
+        printf("Average tour length: greedyLS2 = %.1f (%.3fs); with the Balas-Simonetti neighbourhood of width %d = %.1f (%+.2f%%; %.3fs)\n",
+               (double)lengthLS2/nb_iterations, timeLS2/nb_iterations, k, (double)lengthBS/nb_iterations,
+               100.0*(lengthBS - lengthLS2)/lengthLS2, timeBS/nb_iterations);
+        printGap((double)lengthBS/nb_iterations);
+    }
+    free(sol);
+    bsFree(table);
+}
+
+/**
+ * Iterated local search from a random tour, within a wall-clock budget
+ */
+void solveILS(int n, const costProvider* cost, int k, int moves, ilsParams* params, const char* traceFile, tourOutput* out){
+    candidateLists* cand = candidatesCreate(n, cost, k);
+    int* sol = (int*) malloc(n*sizeof(int));
+    if (cand == NULL || sol == NULL){
+        printf("Not enough memory for the candidate lists.\n");
+        candidatesFree(cand);
+        free(sol);
+        return;
+    }
+    params->trace = NULL;
+    if (traceFile != NULL && (params->trace = fopen(traceFile, "w")) == NULL) printf("Cannot open %s; no trace is written.\n", traceFile);
+    if (params->trace != NULL){
+        setvbuf(params->trace, NULL, _IOFBF, 1 << 20); // a large buffer, so that the search seldom waits for the file
+        fprintf(params->trace, "seconds,length\n");
+    }
+    params->out = out;
+    rng r;
+    rngInit(&r, params->seed, 1);
+    int total = randomTour(n, cost, &r, sol);
+    ilsStats stats;
+    if (total >= 0) total = iteratedLS(n, sol, total, cost, cand, moves, params, &stats);
+    if (total < 0) printf("Not enough memory for the iterated local search.\n");
+    else {
+        printf("Tour length after ILS = %d; wall time = %.3fs\n", total, stats.seconds);
+        printf("    - Iterations = %ld (%.0f/s); accepted = %ld; improvements of the best tour = %ld\n",
+               stats.iterations, stats.seconds > 0 ? stats.iterations/stats.seconds : 0, stats.accepted, stats.improvements);
+        printGap(total); // the tours have been given to out by iteratedLS
+    }
+    if (params->trace != NULL) fclose(params->trace);
+    free(sol);
+    candidatesFree(cand);
+}
+
 int main(int argc, char** argv){
     int n;
 
+    // Options: -k K compares greedyLS2 with the local search restricted to the K nearest neighbours
+    //          -m moves chooses its move types, among 2 (2-opt), o (Or-opt) and 3 (or-3opt); 2 by default
+    //          -s skips greedyLS2 in this comparison (for large instances)
+    //          -w k re-optimises the greedyLS2 tours with exact DP on windows of k consecutive vertices
+    //             (on the threads of -t, if given)
+    //          -b k improves the greedyLS2 tours with the Balas-Simonetti neighbourhood of width k (no vertex moves
+    //             by k positions or more), or, with --time-limit, the tours of each iteration of the ILS;
+    //             its table takes (n+1) 2^(k-1) 2k bytes, so k is limited by the number n of vertices (see bsMaxWidth)
+    //          -t threads runs the restarts in parallel (with greedyLS2, or with the engine chosen by -k and -m)
+    //          -r seed sets the seed of the restarts of -t and of the ILS (1 by default)
+    //          --time-limit seconds runs the iterated local search for this time (with the engine of -k and -m,
+    //                       10 neighbours by default), with the number of double bridges per iteration given by
+    //                       the number of perturbations, and at most the number of iterations (0 for no limit)
+    //          --accept better|walk|threshold:P chooses its acceptance criterion (better by default)
+    //          --trace file writes the best length over time in file (CSV)
+    //          --tour auto|array|list stores the tours searched with -k in a permutation array or in a two-level
+    //                 doubly-linked list (auto: the list from LS_LIST_MIN_VERTICES vertices)
+    //          -d matrix|coords stores the costs in a matrix (default) or computes them from the coordinates
+    //          --instance file solves the TSPLIB instance of file instead of a random one (n is then not given),
+    //                     and reports the gap to the optimal tour of file.opt.tour, if there is one
+    //          --output off|best[:file]|stream[:file] writes no tour, the best tour only (in tours.csv by default),
+    //                   or every tour (in tours.bin by default); a file ending with .csv is written as CSV, others in binary
+    //          --report file writes the instrumentation report in file instead of stderr (make INSTRUMENT=1 or 2)
+    int k = 0;
+    costKind storage = COST_MATRIX16;
+    int nbThreads = 0;
+    int window = 0;
+    int bsWidth = 0;
+    uint64_t seed = 1;
+    ilsParams params = {.timeLimit = 0, .accept = ILS_ACCEPT_BETTER};
+    const char* traceFile = NULL;
+    const char* instanceFile = NULL;
+    outputMode outputChoice = OUTPUT_BEST;
+    const char* outputPath = "tours.csv";
+    const char* reportFile = NULL;
+    static struct option longOptions[] = {
+        {"time-limit", required_argument, NULL, 'T'},
+        {"accept", required_argument, NULL, 'A'},
+        {"trace", required_argument, NULL, 'R'},
+        {"instance", required_argument, NULL, 'I'},
+        {"output", required_argument, NULL, 'O'},
+        {"report", required_argument, NULL, 'P'},
+        {"tour", required_argument, NULL, 'L'},
+        {NULL, 0, NULL, 0}
+    };
+    int moves = LS_MOVE_BIT(LS_2OPT);
+    bool reference = true;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "k:m:sw:b:t:r:d:", longOptions, NULL)) != -1){
+        switch (opt){
+            case 'k':
+                k = atoi(optarg);
+                if (k < 1){
+                    printf("The number of neighbours must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'm':
+                moves = 0;
+                for (char* c = optarg; *c != '\0'; c++){
+                    if (*c == '2') moves |= LS_MOVE_BIT(LS_2OPT);
+                    else if (*c == 'o') moves |= LS_MOVE_BIT(LS_OROPT);
+                    else if (*c == '3') moves |= LS_MOVE_BIT(LS_OR3OPT);
+                    else {
+                        printf("The move types must be among 2, o and 3.\n");
+                        return 0;
+                    }
+                }
+                break;
+            case 's':
+                reference = false;
+                break;
+            case 'w':
+                window = atoi(optarg);
+                if (window < 2 || window > WINDOW_MAX_VERTICES){
+                    printf("The number of vertices of a window must be in [2,%d].\n", WINDOW_MAX_VERTICES);
+                    return 0;
+                }
+                break;
+            case 'b':
+                bsWidth = atoi(optarg);
+                if (bsWidth < 2 || bsWidth > BS_MAX_WIDTH){
+                    printf("The width of the Balas-Simonetti neighbourhood must be in [2,%d] (its table takes (n+1) 2^(k-1) 2k bytes).\n", BS_MAX_WIDTH);
+                    return 0;
+                }
+                break;
+            case 't':
+                nbThreads = atoi(optarg);
+                if (nbThreads < 1){
+                    printf("The number of threads must be a positive integer.\n");
+                    return 0;
+                }
+                break;
+            case 'r':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'd':
+                if (strcmp(optarg, "matrix") == 0) storage = COST_MATRIX16;
+                else if (strcmp(optarg, "coords") == 0) storage = COST_COORDS;
+                else {
+                    printf("The costs must be stored in a matrix or computed from the coords.\n");
+                    return 0;
+                }
+                break;
+            case 'T':
+                params.timeLimit = atof(optarg);
+                if (params.timeLimit <= 0){
+                    printf("The time limit must be a positive number of seconds.\n");
+                    return 0;
+                }
+                break;
+            case 'A':
+                if (strcmp(optarg, "better") == 0) params.accept = ILS_ACCEPT_BETTER;
+                else if (strcmp(optarg, "walk") == 0) params.accept = ILS_ACCEPT_WALK;
+                else if (sscanf(optarg, "threshold:%lf", &params.threshold) == 1) params.accept = ILS_ACCEPT_THRESHOLD;
+                else {
+                    printf("The acceptance criterion must be better, walk or threshold:P.\n");
+                    return 0;
+                }
+                break;
+            case 'R':
+                traceFile = optarg;
+                break;
+            case 'I':
+                instanceFile = optarg;
+                break;
+            case 'O':
+                if (!outputParse(optarg, &outputChoice, &outputPath)){
+                    printf("The output must be off, best[:file] or stream[:file].\n");
+                    return 0;
+                }
+                break;
+            case 'P':
+                reportFile = optarg;
+                break;
+            case 'L':
+                if (strcmp(optarg, "auto") == 0) lsTourChoice = LS_TOUR_AUTO;
+                else if (strcmp(optarg, "array") == 0) lsTourChoice = LS_TOUR_ARRAY;
+                else if (strcmp(optarg, "list") == 0) lsTourChoice = LS_TOUR_LIST;
+                else {
+                    printf("The tours must be stored in an array or a list (or auto).\n");
+                    return 0;
+                }
+                break;
+            default:
+                printf("Usage: %s [-d matrix|coords] [-k neighbours [-m moves] [-s]] [-w k] [-b k] [-t threads [-r seed]]\n"
+                       "       [--time-limit seconds [--accept better|walk|threshold:P] [--trace file]] [--output off|best[:file]|stream[:file]]\n"
+                       "       [--tour auto|array|list] [--report file]\n"
+                       "       [vertices iterations perturbations | --instance file iterations perturbations]\n", argv[0]);
+                return 0;
+        }
+    }
+
+    // the modes are selected in the order --time-limit, -b, -w, -t, -k: reject the options that the selected one would ignore
+    const char* conflict = NULL;
+    if (window > 0 && (params.timeLimit > 0 || bsWidth > 0)) conflict = "-w cannot be combined with --time-limit or -b";
+    else if (nbThreads > 0 && params.timeLimit > 0) conflict = "-t cannot be combined with --time-limit (the ILS runs on one thread)";
+    else if (nbThreads > 0 && bsWidth > 0) conflict = "-t cannot be combined with -b";
+    else if (k > 0 && params.timeLimit == 0 && (bsWidth > 0 || window > 0)) conflict = "-k cannot be combined with -b or -w without --time-limit";
+    else if (traceFile != NULL && params.timeLimit == 0) conflict = "--trace needs --time-limit";
+    if (conflict != NULL){
+        printf("%s.\n", conflict);
+        return 0;
+    }
+
+    instrumentInit(reportFile);
+
     // Get parameters either from command line or from user
     int nb_iterations;
     int nb_perturbations;
-    if (argc > 3) {
-        n = atoi(argv[1]);
-        nb_iterations = atoi(argv[2]);
-        nb_perturbations = atoi(argv[3]);
+    int nbArgs = (instanceFile == NULL) ? 3 : 2; // the number of vertices of an instance is in its file
+    if (argc - optind >= nbArgs) {
+        if (instanceFile == NULL) n = atoi(argv[optind]);
+        nb_iterations = atoi(argv[optind+nbArgs-2]);
+        nb_perturbations = atoi(argv[optind+nbArgs-1]);
     } else {
-        printf("Number of vertices: "); fflush(stdout);
-        scanf("%d",&n);
+        if (instanceFile == NULL){
+            printf("Number of vertices: "); fflush(stdout);
+            scanf("%d",&n);
+        }
         printf("Number of random tour constructions / iterations: "); fflush(stdout);
         scanf("%d",&nb_iterations);
         printf("Number of perturbations: "); fflush(stdout);
         scanf("%d",&nb_perturbations);
     }
 
-    FILE* fd  = fopen("script.py", "w");
-    int** cost = createCost(n, fd);
+    costProvider* cost;
+    if (instanceFile != NULL){
+        clock_t t = clock();
+        cost = loadInstance(instanceFile, storage, &n);
+        if (cost != NULL){
+            printf("Instance %s: %d vertices; load time = %.3fs\n", instanceFile, n, ((double) (clock() - t)) / CLOCKS_PER_SEC);
+            optimum = tsplibOptimum(instanceFile, cost);
+            if (optimum >= 0) printf("Length of the optimal tour = %d\n", optimum);
+        }
+    } else cost = createCost(n, storage);
+    if (cost == NULL){
+        printf(instanceFile == NULL ? "Not enough memory for the costs.\n" : "The instance cannot be loaded.\n");
+        return 0;
+    }
+    printf("Costs: %s, %.1f MB\n", costKindName(cost->kind), costBytes(cost)/1e6);
+    if (bsWidth > 0 && bsWidth < n && bsWidth > bsMaxWidth(n)){
+        printf("The Balas-Simonetti table of width %d takes %.1f MB for %d vertices: the width must be at most %d.\n",
+               bsWidth, bsTableBytes(n, bsWidth)/1e6, n, bsMaxWidth(n));
+        costFree(cost);
+        return 0;
+    }
+    tourOutput* out = outputOpen(outputPath, outputChoice, n, cost->xy);
+    if (out == NULL){
+        printf("Cannot create %s.\n", outputPath);
+        costFree(cost);
+        return 0;
+    }
+    if (params.timeLimit > 0){
+        params.maxIterations = nb_iterations;
+        params.kicksPerIteration = nb_perturbations;
+        params.seed = seed;
+        params.bsWidth = bsWidth;
+        solveILS(n, cost, k > 0 ? k : 10, moves, &params, traceFile, out);
+        costFree(cost);
+        outputClose(out);
+        return 0;
+    }
+    if (bsWidth > 0){
+        compareBalasSimonetti(n, cost, nb_iterations, bsWidth < n ? bsWidth : n-1, out);
+        costFree(cost);
+        outputClose(out);
+        return 0;
+    }
+    if (window > 0){
+        compareWindowLS(n, cost, nb_iterations, window, nbThreads, out);
+        costFree(cost);
+        outputClose(out);
+        return 0;
+    }
+    if (nbThreads > 0){
+        compareMultiStart(n, cost, nb_iterations, k, moves, nbThreads, seed, out);
+        costFree(cost);
+        outputClose(out);
+        return 0;
+    }
+    if (k > 0){
+        compareNeighbourLS(n, cost, nb_iterations, k, moves, reference, out);
+        costFree(cost);
+        outputClose(out);
+        return 0;
+    }
     int sol[n];
     int total;
 
@@ -349,11 +615,11 @@ int main(int argc, char** argv){
         total = generateRandomTour(n, cost, i, sol);
         printf("Trial %d: Initial tour length = %d; ", i, total);
         clock_t t = clock();
-        total = greedyLS2(n, sol, total, cost);
+        total = greedyLS2(n, sol, total, cost, NULL);
         totals1[i] = total;
         float d = ((double) (clock() - t)) / CLOCKS_PER_SEC;
         printf("Tour length after GreedyLS = %d; CPU time = %.3fs\n", total, d);
-        print(sol, n, total, fd);
+        outputTour(out, sol, total);
     }
 
     float global_duration = ((double) (clock() - global_start)) / CLOCKS_PER_SEC;
@@ -367,11 +633,11 @@ int main(int argc, char** argv){
         total = generateRandomTour(n, cost, i, sol);
         printf("Trial %d: Initial tour length = %d; ", i, total);
         clock_t t = clock();
-        total = greedyLS(n, sol, total, cost);
+        total = greedyLS(n, sol, total, cost, NULL);
         totals2[i] = total;
         float d = ((double) (clock() - t)) / CLOCKS_PER_SEC;
         printf("Tour length after GreedyLS = %d; CPU time = %.3fs\n", total, d);
-        print(sol, n, total, fd);
+        outputTour(out, sol, total);
     }
 
     global_duration = ((double) (clock() - global_start)) / CLOCKS_PER_SEC;
@@ -394,10 +660,11 @@ int main(int argc, char** argv){
     // total = iterative_greedy_LS(n, sol, total, cost, nb_iterations, nb_perturbations);
     // float d = ((double) (clock() - t)) / CLOCKS_PER_SEC;
     // printf("Tour length after ILS = %d; CPU time = %.3fs\n", total, d);
-    // print(sol, n, total, fd);
+    // outputTour(out, sol, total);
     
     
-    fclose(fd);
+    costFree(cost);
+    outputClose(out);
     return 0;
 };
 
@@ -0,0 +1,360 @@
+/*
+ Instances and tours in the TSPLIB format
+
+ The file is mapped in memory and parsed in place: numbers are read directly from the mapping,
+ without a copy of the text nor the NUL-terminated strings strtod would need. Supported instances
+ are symmetric (TYPE : TSP) with EDGE_WEIGHT_TYPE EUC_2D, CEIL_2D, ATT, GEO, or EXPLICIT with
+ EDGE_WEIGHT_FORMAT FULL_MATRIX or UPPER_ROW. Vertices are numbered from 0, TSPLIB ones from 1.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "tsplib.h"
+
+#define WORD 64
+#define TSPLIB_PI 3.141592 // the value used by TSPLIB to convert GEO coordinates, kept for identical costs
+
+typedef struct {
+    const char* p;   // next character to read
+    const char* end; // end of the mapping
+} scanner;
+
+static const char* mapFile(const char* path, size_t* size, bool quiet){
+    // Postcondition: return the content of the file mapped read-only, and its size in size, or NULL
+    //                (with a message, unless quiet and the file does not exist)
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        if (!quiet || errno != ENOENT) fprintf(stderr, "Cannot open %s.\n", path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0){
+        fprintf(stderr, "%s is empty or cannot be read.\n", path);
+        close(fd);
+        return NULL;
+    }
+    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED){
+        fprintf(stderr, "Cannot map %s.\n", path);
+        return NULL;
+    }
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    *size = st.st_size;
+    return (const char*) p;
+}
+
+static inline bool isBlank(char c){
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isSpace(char c){
+    return isBlank(c) || c == '\n';
+}
+
+static inline bool isDigit(char c){
+    return c >= '0' && c <= '9';
+}
+
+static void skipSpaces(scanner* sc){
+    while (sc->p < sc->end && isSpace(*sc->p)) sc->p++;
+}
+
+static bool readNumber(scanner* sc, double* x){
+    // Postcondition: if the next token is a number, it is read in x and true is returned
+    // A mantissa of at most 2^53 scaled by a power of 10 up to 10^22 is rounded once, as by strtod (both are exact
+    // doubles); the other numbers (more than 15 to 16 significant digits, or large exponents) are read by strtod.
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    skipSpaces(sc);
+    const char* p = sc->p;
+    const char* end = sc->end;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    bool dropped = false; // digits beyond the 17th, only counted in the exponent
+    for (; p < end && isDigit(*p); p++, digits++){
+        if (mantissa < 10000000000000000ull) mantissa = 10*mantissa + (*p - '0');
+        else {
+            exponent++;
+            dropped = true;
+        }
+    }
+    if (p < end && *p == '.'){
+        for (p++; p < end && isDigit(*p); p++, digits++){
+            if (mantissa < 10000000000000000ull){
+                mantissa = 10*mantissa + (*p - '0');
+                exponent--;
+            } else dropped = true;
+        }
+    }
+    if (digits == 0) return false;
+    if (p < end && (*p == 'e' || *p == 'E')){
+        p++;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExp = (*p++ == '-');
+        int e = 0;
+        if (p == end || !isDigit(*p)) return false;
+        for (; p < end && isDigit(*p); p++) if (e < 10000) e = 10*e + (*p - '0');
+        exponent += negativeExp ? -e : e;
+    }
+    double v;
+    char token[64];
+    if (!dropped && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22){
+        v = (double)mantissa;
+        if (exponent < 0) v /= powers[-exponent];
+        else v *= powers[exponent];
+        if (negative) v = -v;
+    } else if (p - sc->p < (ptrdiff_t)sizeof(token)){
+        // the file is not terminated by '\0': strtod reads a copy of the token
+        memcpy(token, sc->p, p - sc->p);
+        token[p - sc->p] = '\0';
+        v = strtod(token, NULL);
+    } else {
+        // longer than any number of a TSPLIB file: rounded more than once
+        v = (double)mantissa * pow(10.0, exponent);
+        if (negative) v = -v;
+    }
+    *x = v;
+    sc->p = p;
+    return true;
+}
+
+static bool readInt(scanner* sc, int* x){
+    double v;
+    if (!readNumber(sc, &v) || v != (int)v) return false;
+    *x = (int)v;
+    return true;
+}
+
+static bool readKeyword(scanner* sc, char* word){
+    // Postcondition: the next keyword (word of at most WORD-1 characters, followed by an optional ':') is read in word;
+    //                return false at the end of the file
+    skipSpaces(sc);
+    if (sc->p == sc->end) return false;
+    int k = 0;
+    while (sc->p < sc->end && !isSpace(*sc->p) && *sc->p != ':'){
+        if (k < WORD-1) word[k++] = *sc->p;
+        sc->p++;
+    }
+    word[k] = '\0';
+    while (sc->p < sc->end && isBlank(*sc->p)) sc->p++;
+    if (sc->p < sc->end && *sc->p == ':') sc->p++;
+    return true;
+}
+
+static void readValue(scanner* sc, char* value){
+    // Postcondition: the rest of the line, without its surrounding blanks, is read in value (truncated to WORD-1 characters)
+    while (sc->p < sc->end && isBlank(*sc->p)) sc->p++;
+    int k = 0;
+    while (sc->p < sc->end && *sc->p != '\n'){
+        if (k < WORD-1) value[k++] = *sc->p;
+        sc->p++;
+    }
+    while (k > 0 && isBlank(value[k-1])) k--;
+    value[k] = '\0';
+}
+
+static bool readCoords(scanner* sc, tsplibInstance* inst, bool geo){
+    // Postcondition: the n lines "id x y" of a coordinate section are read in inst->xy;
+    //                return false unless each id of [1,n] appears once
+    inst->xy = (double*) malloc(2*(size_t)inst->n*sizeof(double));
+    bool* seen = (bool*) calloc(inst->n, sizeof(bool));
+    if (inst->xy == NULL || seen == NULL){
+        free(seen);
+        return false;
+    }
+    for (int k=0; k<inst->n; k++){
+        int id;
+        double x, y;
+        if (!readInt(sc, &id) || id < 1 || id > inst->n || seen[id-1] || !readNumber(sc, &x) || !readNumber(sc, &y)){
+            free(seen);
+            return false;
+        }
+        seen[id-1] = true;
+        if (geo){
+            // DDD.MM: degrees and minutes, converted into radians
+            int deg = (int)x;
+            x = TSPLIB_PI * (deg + 5.0*(x - deg)/3.0) / 180.0;
+            deg = (int)y;
+            y = TSPLIB_PI * (deg + 5.0*(y - deg)/3.0) / 180.0;
+        }
+        inst->xy[2*(id-1)] = x;
+        inst->xy[2*(id-1)+1] = y;
+    }
+    free(seen);
+    return true;
+}
+
+static bool readWeights(scanner* sc, tsplibInstance* inst, bool upperRow){
+    // Postcondition: the weights of a FULL_MATRIX or UPPER_ROW section are read in inst->weights
+    int n = inst->n;
+    inst->weights = (int32_t*) calloc((size_t)n*n, sizeof(int32_t));
+    if (inst->weights == NULL) return false;
+    for (size_t i=0; i<(size_t)n; i++){
+        for (size_t j = upperRow ? i+1 : 0; j<(size_t)n; j++){
+            int w;
+            if (!readInt(sc, &w) || w < 0) return false;
+            inst->weights[i*n + j] = w;
+            if (upperRow) inst->weights[j*n + i] = w;
+        }
+    }
+    return true;
+}
+
+/**
+ * Load the TSPLIB instance of file path
+ * Return NULL, with a message on stderr, if the file cannot be read, is not a supported instance, or if there is not enough memory
+ */
+tsplibInstance* tsplibLoad(const char* path){
+    size_t size;
+    const char* text = mapFile(path, &size, false);
+    if (text == NULL) return NULL;
+    tsplibInstance* inst = (tsplibInstance*) calloc(1, sizeof(tsplibInstance));
+    if (inst == NULL){
+        munmap((void*)text, size);
+        return NULL;
+    }
+    scanner sc = {text, text + size};
+    char word[WORD], value[WORD];
+    char type[WORD] = "", format[WORD] = "";
+    bool weightType = false;
+    const char* error = NULL;
+    while (error == NULL && readKeyword(&sc, word)){
+        if (strcmp(word, "EOF") == 0) break;
+        if (strcmp(word, "NODE_COORD_SECTION") == 0 || strcmp(word, "DISPLAY_DATA_SECTION") == 0){
+            if (inst->n == 0 || !weightType) error = "DIMENSION and EDGE_WEIGHT_TYPE must come before the coordinates";
+            else if (inst->xy != NULL) error = "the coordinates are given twice";
+            else if (!readCoords(&sc, inst, !inst->explicitWeights && inst->metric == METRIC_GEO)) error = "invalid coordinates";
+        } else if (strcmp(word, "EDGE_WEIGHT_SECTION") == 0){
+            bool upperRow = (strcmp(format, "UPPER_ROW") == 0);
+            if (inst->n == 0) error = "DIMENSION must come before the weights";
+            else if (!inst->explicitWeights) error = "EDGE_WEIGHT_SECTION without EDGE_WEIGHT_TYPE : EXPLICIT";
+            else if (!upperRow && strcmp(format, "FULL_MATRIX") != 0) error = "the EDGE_WEIGHT_FORMAT must be FULL_MATRIX or UPPER_ROW";
+            else if (!readWeights(&sc, inst, upperRow)) error = "invalid weights";
+        } else if (strstr(word, "_SECTION") != NULL){
+            error = "unsupported section";
+        } else {
+            readValue(&sc, value);
+            if (strcmp(word, "NAME") == 0) strcpy(inst->name, value);
+            else if (strcmp(word, "TYPE") == 0) strcpy(type, value);
+            else if (strcmp(word, "DIMENSION") == 0){
+                inst->n = atoi(value);
+                if (inst->n < 1) error = "invalid DIMENSION";
+            } else if (strcmp(word, "EDGE_WEIGHT_FORMAT") == 0) strcpy(format, value);
+            else if (strcmp(word, "EDGE_WEIGHT_TYPE") == 0){
+                weightType = true;
+                if (strcmp(value, "EUC_2D") == 0) inst->metric = METRIC_EUC_2D;
+                else if (strcmp(value, "CEIL_2D") == 0) inst->metric = METRIC_CEIL_2D;
+                else if (strcmp(value, "ATT") == 0) inst->metric = METRIC_ATT;
+                else if (strcmp(value, "GEO") == 0) inst->metric = METRIC_GEO;
+                else if (strcmp(value, "EXPLICIT") == 0) inst->explicitWeights = true;
+                else error = "the EDGE_WEIGHT_TYPE must be EUC_2D, CEIL_2D, ATT, GEO or EXPLICIT";
+            } // other keywords (COMMENT, DISPLAY_DATA_TYPE, ...) are ignored
+        }
+    }
+    if (error == NULL && strcmp(type, "TSP") != 0) error = "the TYPE must be TSP";
+    if (error == NULL && !weightType) error = "no EDGE_WEIGHT_TYPE";
+    if (error == NULL && inst->explicitWeights && inst->weights == NULL) error = "no EDGE_WEIGHT_SECTION";
+    if (error == NULL && !inst->explicitWeights && inst->xy == NULL) error = "no NODE_COORD_SECTION";
+    munmap((void*)text, size);
+    if (error != NULL){
+        fprintf(stderr, "%s: %s.\n", path, error);
+        tsplibFree(inst);
+        return NULL;
+    }
+    return inst;
+}
+
+void tsplibFree(tsplibInstance* inst){
+    if (inst == NULL) return;
+    free(inst->xy);
+    free(inst->weights);
+    free(inst);
+}
+
+costProvider* tsplibCost(const tsplibInstance* inst, costKind kind){
+    // Postcondition: return the costs of inst, stored as asked by kind when the instance has coordinates, or NULL
+    if (inst->explicitWeights) return costFromWeights(inst->n, inst->weights, kind);
+    return costFromPoints(inst->n, inst->xy, inst->metric, kind);
+}
+
+static int tourLength(const char* path, const costProvider* cost, bool quiet){
+    size_t size;
+    const char* text = mapFile(path, &size, quiet);
+    if (text == NULL) return -1;
+    int n = cost->n;
+    scanner sc = {text, text + size};
+    char word[WORD], value[WORD];
+    const char* error = "no TOUR_SECTION";
+    int length = 0;
+    while (readKeyword(&sc, word) && strcmp(word, "EOF") != 0){
+        if (strcmp(word, "TOUR_SECTION") != 0){
+            readValue(&sc, value);
+            continue;
+        }
+        // the vertices of the tour, terminated by -1
+        bool* seen = (bool*) calloc(n, sizeof(bool));
+        if (seen == NULL){
+            error = "not enough memory";
+            break;
+        }
+        int first = -1, last = -1, count = 0, id;
+        error = NULL;
+        while (error == NULL && readInt(&sc, &id) && id != -1){
+            if (id < 1 || id > n || seen[id-1]) error = "not a tour of the instance";
+            else {
+                seen[id-1] = true;
+                if (last < 0) first = id-1;
+                else length += costOf(cost, last, id-1);
+                last = id-1;
+                count++;
+            }
+        }
+        if (error == NULL && count != n) error = "not a tour of the instance";
+        if (error == NULL) length += costOf(cost, last, first);
+        free(seen);
+        break;
+    }
+    munmap((void*)text, size);
+    if (error != NULL){
+        fprintf(stderr, "%s: %s.\n", path, error);
+        return -1;
+    }
+    return length;
+}
+
+/**
+ * Length of the tour of the TSPLIB file path (TOUR_SECTION) with the costs cost
+ * Return -1, with a message on stderr, if the file cannot be read or is not a tour of the n vertices
+ */
+int tsplibTourLength(const char* path, const costProvider* cost){
+    return tourLength(path, cost, false);
+}
+
+/**
+ * Length of the optimal tour of the instance of file instancePath, read from the file of same name
+ * with the extension .opt.tour, as in the TSPLIB distribution
+ * Return -1 if there is no such file (silently) or if it cannot be read
+ */
+int tsplibOptimum(const char* instancePath, const costProvider* cost){
+    size_t len = strlen(instancePath);
+    if (len > 4 && strcmp(instancePath + len - 4, ".tsp") == 0) len -= 4;
+    char* path = (char*) malloc(len + sizeof(".opt.tour"));
+    if (path == NULL) return -1;
+    memcpy(path, instancePath, len);
+    strcpy(path + len, ".opt.tour");
+    int length = tourLength(path, cost, true);
+    free(path);
+    return length;
+}
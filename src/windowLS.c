@@ -0,0 +1,214 @@
+/*
+ Re-optimisation of a tour by exact DP on windows of consecutive vertices
+
+ A window is a sequence of k consecutive vertices of the tour, between two end points that stay in
+ place. windowOptimise computes the best order of its k vertices with the bottom-up recurrence of
+ heldKarp_iter, in which the depot is replaced by the right end point and the tour is closed on the
+ left end point instead: O(k^2 2^k) time, in a table allocated once per thread and reused for all
+ windows. The costs between the vertices of the window are read once into a k x k matrix, so that
+ the sweep does not depend on the storage of the costs.
+
+ A pass slides the windows along the tour in rounds: the windows of a round start every k+1
+ positions, so that their vertices are disjoint and their end points belong to no window of the
+ round. They are dealt to the threads, which write their new orders in disjoint parts of sol.
+ The next round starts k/2 positions further, so that the borders of the windows of a round lie
+ inside those of the next one. Passes are repeated until no window improves the tour.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "windowLS.h"
+#include "timer.h"
+
+windowTable* windowTableCreate(int k){
+    // Precondition: 1 <= k <= WINDOW_MAX_VERTICES
+    // Postcondition: return a table for windows of k vertices, or NULL if there is not enough memory
+    windowTable* w = (windowTable*) calloc(1, sizeof(windowTable));
+    if (w == NULL) return NULL;
+    w->k = k;
+    size_t nbCells = (size_t)k << k;
+    w->dp = (int32_t*) malloc(nbCells*sizeof(int32_t));
+    w->succ = (int8_t*) malloc(nbCells*sizeof(int8_t));
+    w->costs = (int32_t*) malloc((size_t)k*k*sizeof(int32_t));
+    w->toRight = (int32_t*) malloc(k*sizeof(int32_t));
+    w->fromLeft = (int32_t*) malloc(k*sizeof(int32_t));
+    if (w->dp == NULL || w->succ == NULL || w->costs == NULL || w->toRight == NULL || w->fromLeft == NULL){
+        windowTableFree(w);
+        return NULL;
+    }
+    return w;
+}
+
+void windowTableFree(windowTable* w){
+    if (w == NULL) return;
+    free(w->dp);
+    free(w->succ);
+    free(w->costs);
+    free(w->toRight);
+    free(w->fromLeft);
+    free(w);
+}
+
+/**
+ * Best order of the k vertices cities[0..k-1] of a path from left to right (left and right excluded)
+ * Output: cities[0..k-1] is this order (unchanged if the current one is already optimal)
+ * Return the change of length of the path (<= 0)
+ */
+int windowOptimise(windowTable* w, const costProvider* cost, int left, int* cities, int right){
+    int k = w->k;
+    int32_t* dp = w->dp;
+    int8_t* succ = w->succ;
+    int32_t* c = w->costs;
+    int current = costOf(cost, left, cities[0]) + costOf(cost, cities[k-1], right);
+    for (int i=0; i<k; i++){
+        w->toRight[i] = costOf(cost, cities[i], right);
+        w->fromLeft[i] = costOf(cost, left, cities[i]);
+        for (int j=0; j<k; j++) c[i*k + j] = costOf(cost, cities[i], cities[j]);
+        if (i > 0) current += c[(i-1)*k + i];
+    }
+
+    // base case: go to the right end point
+    for (int i=1; i<=k; i++){
+        dp[i-1] = w->toRight[i-1];
+        succ[i-1] = 0;
+    }
+    set ALL = createSet(k+1); // {1,...,k}
+    for (set S=1; S<ALL; ++S){ // all proper subsets of the window
+        int i, j;
+        size_t base = setIndex(S)*k;
+        forEachElement(i, ALL & ~S){ // i must not be in S
+            int best = INT_MAX;
+            int bestj = -1;
+            const int32_t* ci = c + (i-1)*k;
+            forEachElement(j, S){ // j must be in S
+                int alt = ci[j-1] + dp[setIndex(removeElement(S,j))*k + j-1];
+                if (alt < best){
+                    best = alt;
+                    bestj = j;
+                }
+            }
+            dp[base + i-1] = best;
+            succ[base + i-1] = bestj;
+        }
+    }
+
+    // start from the left end point
+    int best = INT_MAX;
+    int bestj = -1;
+    for (int j=1; j<=k; j++){
+        int alt = w->fromLeft[j-1] + dp[setIndex(removeElement(ALL,j))*k + j-1];
+        if (alt < best){
+            best = alt;
+            bestj = j;
+        }
+    }
+    if (best >= current) return 0;
+
+    int order[WINDOW_MAX_VERTICES];
+    set S = ALL;
+    for (int p=0, j=bestj; p<k; p++){
+        order[p] = cities[j-1];
+        S = removeElement(S, j);
+        j = succ[setIndex(S)*k + j-1];
+    }
+    memcpy(cities, order, k*sizeof(int));
+    return best - current;
+}
+
+typedef struct {
+    int n;
+    int* sol;
+    const costProvider* cost;
+    int k;
+    int offset;           // position of the first vertex of the first window of the round
+    int nbWindows;        // number of windows of the round
+    atomic_int next;      // next window to solve
+} windowRound;
+
+typedef struct {
+    windowRound* round;
+    windowTable* table;
+    int* cities;          // the vertices of the current window (sol is cyclic, a window may wrap around)
+    long delta;           // change of length of the tour by the windows of this worker
+    long improved;
+    pthread_t thread;
+} windowWorker;
+
+static void* solveWindows(void* arg){
+    windowWorker* w = (windowWorker*) arg;
+    windowRound* r = w->round;
+    int n = r->n, k = r->k;
+    while (true){
+        int m = atomic_fetch_add_explicit(&r->next, 1, memory_order_relaxed);
+        if (m >= r->nbWindows) return NULL;
+        int first = r->offset + m*(k+1);
+        for (int p=0; p<k; p++) w->cities[p] = r->sol[(first + p) % n];
+        int delta = windowOptimise(w->table, r->cost, r->sol[(first + n - 1) % n], w->cities, r->sol[(first + k) % n]);
+        if (delta < 0){
+            for (int p=0; p<k; p++) r->sol[(first + p) % n] = w->cities[p];
+            w->delta += delta;
+            w->improved++;
+        }
+    }
+}
+
+/**
+ * Window re-optimisation of a tour
+ * Input: sol[0..n-1] contains a permutation of [0,n-1], total = length of the tour associated with sol,
+ *        k = number of vertices of a window, nbThreads = number of threads solving the windows of a round
+ * Output: sol[0..n-1] is a tour in which the order of every k consecutive vertices is optimal
+ *         (between windows of the rounds described above), and stats (if not NULL) is filled
+ * Return the length of the tour associated with sol, or -1 if there is not enough memory
+ */
+int windowLS(int n, int* sol, int total, const costProvider* cost, int k, int nbThreads, windowStats* stats){
+    double start = wallTime();
+    windowStats local;
+    if (stats == NULL) stats = &local;
+    *stats = (windowStats){0};
+    if (k > n-2) k = n-2; // two end points are left out of a window
+    if (k < 2) return total;
+    if (nbThreads < 1) nbThreads = 1;
+    int shift = (k/2 > 0) ? k/2 : 1;
+    windowRound round = {.n = n, .sol = sol, .cost = cost, .k = k, .nbWindows = n/(k+1)};
+    if (nbThreads > round.nbWindows) nbThreads = round.nbWindows;
+    windowWorker workers[nbThreads];
+    bool ok = true;
+    for (int t=0; t<nbThreads; t++){
+        workers[t].round = &round;
+        workers[t].table = windowTableCreate(k);
+        workers[t].cities = (int*) malloc(k*sizeof(int));
+        ok = ok && workers[t].table != NULL && workers[t].cities != NULL;
+    }
+    bool improved = ok;
+    while (improved){
+        stats->passes++;
+        improved = false;
+        for (round.offset = 0; round.offset < k+1; round.offset += shift){
+            atomic_store_explicit(&round.next, 0, memory_order_relaxed);
+            for (int t=0; t<nbThreads; t++){
+                workers[t].delta = 0;
+                workers[t].improved = 0;
+            }
+            int launched = 1;
+            while (launched < nbThreads && pthread_create(&workers[launched].thread, NULL, solveWindows, &workers[launched]) == 0) launched++;
+            solveWindows(&workers[0]); // the calling thread is worker 0
+            for (int t=1; t<launched; t++) pthread_join(workers[t].thread, NULL);
+            stats->windows += round.nbWindows;
+            for (int t=0; t<nbThreads; t++){
+                total += workers[t].delta;
+                stats->improved += workers[t].improved;
+                if (workers[t].improved > 0) improved = true;
+            }
+        }
+    }
+    for (int t=0; t<nbThreads; t++){
+        windowTableFree(workers[t].table);
+        free(workers[t].cities);
+    }
+    stats->seconds = wallTime() - start;
+    return ok ? total : -1;
+}